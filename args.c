@@ -0,0 +1,52 @@
+/*
+ * Hocoslamfy, command-line argument code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "args.h"
+
+bool ParseUint64(const char* Text, uint64_t* Value)
+{
+	char* End;
+	unsigned long long Number;
+
+	// strtoull skips spaces and takes a sign, wrapping negative numbers
+	// around, so the argument must start with a digit.
+	if (*Text < '0' || *Text > '9')
+		return false;
+	errno = 0;
+	Number = strtoull(Text, &End, 10);
+	if (*End != '\0' || errno == ERANGE)
+		return false;
+	*Value = (uint64_t) Number;
+	return true;
+}
+
+bool ParseUint32(const char* Text, uint32_t Min, uint32_t* Value)
+{
+	uint64_t Number;
+
+	if (!ParseUint64(Text, &Number) || Number < Min || Number > UINT32_MAX)
+		return false;
+	*Value = (uint32_t) Number;
+	return true;
+}
@@ -0,0 +1,34 @@
+/*
+ * Hocoslamfy, command-line argument header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _ARGS_H_
+#define _ARGS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Reads a command-line argument that must be a whole decimal number, and
+// nothing else, into Value. Returns false, leaving Value alone, if it isn't
+// one, or if it doesn't fit.
+extern bool ParseUint64(const char* Text, uint64_t* Value);
+
+// The same, for a number from Min to UINT32_MAX.
+extern bool ParseUint32(const char* Text, uint32_t Min, uint32_t* Value);
+
+#endif /* !defined(_ARGS_H_) */
@@ -0,0 +1,405 @@
+/*
+ * Hocoslamfy, batch simulation code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "init.h"
+#include "game.h"
+#include "sim.h"
+#include "collision.h"
+#include "batch.h"
+
+// What the player collides with in a column, which is the same for all games:
+// the player's center collides with the column's rectangles when it's within
+// HalfHeight of the gap's edges or beyond them (see the hitboxes in
+// collision.h). HalfHeight is that of the player's collision rectangle B
+// while the column is within reach of B horizontally, and otherwise that of
+// A, since B is narrower and taller than A.
+struct ColumnReach
+{
+	uint32_t Slot;
+	fixed    HalfHeight;
+};
+
+struct BatchRun
+{
+	struct GameBatch* Batch;
+	TBatchController  Controller;
+	void*             Data;
+	uint32_t          NextChunk;
+};
+
+uint32_t BatchColumnSlot(const struct BatchColumns* Columns, uint32_t Index)
+{
+	return (Columns->Start + Index) & (BATCH_COLUMN_CAPACITY - 1);
+}
+
+void BatchAutopilotController(const struct GameBatch* Batch, const struct BatchColumns* Columns,
+	uint32_t First, uint32_t Count, int32_t* Boost, void* Data)
+{
+	uint32_t i, Slot = BATCH_COLUMN_CAPACITY;
+	for (i = 0; i < Columns->Count; i++)
+		if (Columns->Left[BatchColumnSlot(Columns, i)] + FIXED_RECT_WIDTH > FIXED_PLAYER_X - FIXED(0.2))
+		{
+			Slot = BatchColumnSlot(Columns, i);
+			break;
+		}
+
+	const fixed* Aim = Data;
+	for (i = 0; i < Count; i++)
+	{
+		fixed Target = Slot != BATCH_COLUMN_CAPACITY
+			? Batch->GapTop[Slot * Batch->Stride + First + i] - Batch->Parameters.GapHeight / 2
+			: FIXED_FIELD_HEIGHT / 2;
+		if (Aim != NULL)
+			Target += Aim[First + i];
+		Boost[i] = Batch->PlayerY[First + i] < Target - FIXED(0.25)
+		        && Batch->PlayerSpeed[First + i] < FIXED(0.5 / 1000);
+	}
+}
+
+static bool IsBetween(fixed Edge, fixed Low, fixed High)
+{
+	return Edge > Low && Edge < High;
+}
+
+// Scrolls the columns by a millisecond's worth, awarding points to the games
+// still being played for those that went past the player, removes those that
+// went past the left side and generates a new column if needed.
+// These are steps a) and b) of AdvanceGameState.
+static void AdvanceColumns(struct GameBatch* Batch, struct BatchColumns* Columns, uint32_t First, uint32_t Count)
+{
+	struct FieldEvent Event;
+	uint32_t i, Game;
+	for (i = 0; i < Columns->Count; i++)
+		Columns->Left[BatchColumnSlot(Columns, i)] += Batch->Parameters.FieldScroll;
+	while (Columns->Cursor < Columns->Count
+	    && Columns->Left[BatchColumnSlot(Columns, Columns->Cursor)] + FIXED_RECT_WIDTH <= FIXED_PLAYER_X - COLLISION_A_HALF_WIDTH)
+		Columns->Cursor++;
+	while (PopFieldEvent(&Columns->Events, Columns->Time, &Event))
+	{
+		if (Event.Type == FIELD_EVENT_PASS)
+		{
+			for (Game = First; Game < First + Count; Game++)
+				Batch->Score[Game] += Batch->Playing[Game] & 1;
+		}
+		else
+		{
+			Columns->Start = (Columns->Start + 1) & (BATCH_COLUMN_CAPACITY - 1);
+			Columns->Count--;
+			Columns->Cursor--;
+		}
+	}
+
+	fixed Left;
+	if (Columns->Count == 0)
+		Left = FIXED_FIELD_WIDTH + Batch->Parameters.FieldScroll;
+	else
+	{
+		fixed LastRight = Columns->Left[BatchColumnSlot(Columns, Columns->Count - 1)] + FIXED_RECT_WIDTH;
+		if (FIXED_FIELD_WIDTH - LastRight < Columns->GenDistance)
+			return;
+		Left = LastRight + Columns->GenDistance;
+		Columns->GenDistance += Batch->Parameters.RectGenSpeed;
+		if (Columns->GenDistance < Batch->Parameters.RectGenMin)
+			Columns->GenDistance = Batch->Parameters.RectGenMin;
+	}
+	uint32_t Slot = BatchColumnSlot(Columns, Columns->Count++);
+	Columns->Left[Slot] = Left;
+	ScheduleFieldEvent(&Columns->Events,
+		Columns->Time + StepsUntilLeftOf(Left + FIXED_RECT_WIDTH, FIXED_PLAYER_X, Batch->Parameters.FieldScroll),
+		FIELD_EVENT_PASS, Slot);
+	ScheduleFieldEvent(&Columns->Events,
+		Columns->Time + StepsUntilLeftOf(Left + FIXED_RECT_WIDTH, 0, Batch->Parameters.FieldScroll),
+		FIELD_EVENT_REMOVE, Slot);
+	fixed* GapTop = &Batch->GapTop[Slot * Batch->Stride];
+	for (Game = First; Game < First + Count; Game++)
+		if (Batch->Playing[Game])
+			GapTop[Game] = GenerateGapTop(&Batch->Gaps[Game]);
+}
+
+// Gathers the columns whose rectangles are within reach of the player
+// horizontally. Returns the number of them.
+static uint32_t GetColumnsInReach(const struct BatchColumns* Columns, struct ColumnReach* Reach)
+{
+	uint32_t i, Count = 0;
+	for (i = Columns->Cursor; i < Columns->Count; i++)
+	{
+		uint32_t Slot = BatchColumnSlot(Columns, i);
+		fixed Left = Columns->Left[Slot], Right = Left + FIXED_RECT_WIDTH;
+		if (Left >= FIXED_PLAYER_X + COLLISION_A_HALF_WIDTH)
+			break;
+		Reach[Count].Slot = Slot;
+		if (IsBetween(FIXED_PLAYER_X, Left - COLLISION_B_HALF_WIDTH, Right + COLLISION_B_HALF_WIDTH))
+			Reach[Count++].HalfHeight = COLLISION_B_HALF_HEIGHT;
+		else if (IsBetween(FIXED_PLAYER_X, Left - COLLISION_A_HALF_WIDTH, Right + COLLISION_A_HALF_WIDTH))
+			Reach[Count++].HalfHeight = COLLISION_A_HALF_HEIGHT;
+	}
+	return Count;
+}
+
+// Steps the players of 4 games starting at Game by a millisecond, per steps c)
+// and d) of AdvanceGameState, boosting those for which Boost is non-zero.
+// Returns a mask in which bit i is set if the player of game Game + i
+// collided with something, and sets the same bit of BorderMask if that was
+// the border of the field.
+#ifdef __SSE2__
+
+static uint32_t StepPlayers4(struct GameBatch* Batch, uint32_t Game, const int32_t* Boost,
+	const struct ColumnReach* Reach, uint32_t ReachCount, uint32_t* BorderMask)
+{
+	__m128i Playing = _mm_loadu_si128((const __m128i*) &Batch->Playing[Game]);
+	if (_mm_movemask_epi8(Playing) == 0)
+		return 0;
+
+	__m128i Zero     = _mm_setzero_si128();
+	__m128i OldSpeed = _mm_loadu_si128((const __m128i*) &Batch->PlayerSpeed[Game]);
+	__m128i OldY     = _mm_loadu_si128((const __m128i*) &Batch->PlayerY[Game]);
+	__m128i NoBoost  = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) Boost), Zero);
+	__m128i Speed    = _mm_add_epi32(
+		_mm_or_si128(_mm_and_si128(NoBoost, OldSpeed),
+		             _mm_andnot_si128(NoBoost, _mm_set1_epi32(Batch->Parameters.SpeedBoost - Batch->Parameters.Gravity))),
+		_mm_set1_epi32(Batch->Parameters.Gravity));
+	__m128i Y        = _mm_add_epi32(OldY, Speed);
+	// Games that are over keep the position of their collision.
+	Speed = _mm_or_si128(_mm_and_si128(Playing, Speed), _mm_andnot_si128(Playing, OldSpeed));
+	Y     = _mm_or_si128(_mm_and_si128(Playing, Y),     _mm_andnot_si128(Playing, OldY));
+	_mm_storeu_si128((__m128i*) &Batch->PlayerSpeed[Game], Speed);
+	_mm_storeu_si128((__m128i*) &Batch->PlayerY[Game], Y);
+
+	__m128i Border = _mm_or_si128(
+		_mm_cmpgt_epi32(_mm_add_epi32(Y, _mm_set1_epi32(COLLISION_B_HALF_HEIGHT)), _mm_set1_epi32(FIXED_FIELD_HEIGHT)),
+		_mm_cmplt_epi32(_mm_sub_epi32(Y, _mm_set1_epi32(COLLISION_B_HALF_HEIGHT)), Zero));
+	__m128i Hit = Border;
+	uint32_t i;
+	for (i = 0; i < ReachCount; i++)
+	{
+		__m128i GapTop = _mm_loadu_si128((const __m128i*) &Batch->GapTop[Reach[i].Slot * Batch->Stride + Game]);
+		Hit = _mm_or_si128(Hit, _mm_or_si128(
+			_mm_cmpgt_epi32(Y, _mm_sub_epi32(GapTop, _mm_set1_epi32(Reach[i].HalfHeight))),
+			_mm_cmplt_epi32(Y, _mm_sub_epi32(GapTop, _mm_set1_epi32(Batch->Parameters.GapHeight - Reach[i].HalfHeight)))));
+	}
+
+	*BorderMask = (uint32_t) _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(Playing, Border)));
+	return (uint32_t) _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(Playing, Hit)));
+}
+
+#else /* !defined(__SSE2__) */
+
+static uint32_t StepPlayers4(struct GameBatch* Batch, uint32_t Game, const int32_t* Boost,
+	const struct ColumnReach* Reach, uint32_t ReachCount, uint32_t* BorderMask)
+{
+	uint32_t Result = 0, i, j;
+	*BorderMask = 0;
+	for (i = 0; i < 4; i++)
+	{
+		uint32_t Index = Game + i;
+		if (!Batch->Playing[Index])
+			continue;
+		if (Boost[i])
+			Batch->PlayerSpeed[Index] = Batch->Parameters.SpeedBoost - Batch->Parameters.Gravity;
+		Batch->PlayerSpeed[Index] += Batch->Parameters.Gravity;
+		Batch->PlayerY[Index] += Batch->PlayerSpeed[Index];
+
+		fixed Y = Batch->PlayerY[Index];
+		if (Y + COLLISION_B_HALF_HEIGHT > FIXED_FIELD_HEIGHT || Y - COLLISION_B_HALF_HEIGHT < 0)
+		{
+			*BorderMask |= 1 << i;
+			Result |= 1 << i;
+			continue;
+		}
+		for (j = 0; j < ReachCount; j++)
+		{
+			fixed GapTop = Batch->GapTop[Reach[j].Slot * Batch->Stride + Index];
+			if (Y > GapTop - Reach[j].HalfHeight
+			 || Y < GapTop - Batch->Parameters.GapHeight + Reach[j].HalfHeight)
+			{
+				Result |= 1 << i;
+				break;
+			}
+		}
+	}
+	return Result;
+}
+
+#endif /* !defined(__SSE2__) */
+
+// Plays the Count games starting at First, which is a multiple of
+// BATCH_CHUNK_SIZE, to the end.
+static void PlayChunk(struct GameBatch* Batch, uint32_t First, uint32_t Count, TBatchController Controller, void* Data)
+{
+	struct BatchColumns Columns = {
+		.Start = 0,
+		.Count = 0,
+		.Cursor = 0,
+		.GenDistance = Batch->Parameters.RectGenStart,
+		.Time = 0,
+		.Events = { .Start = 0, .Count = 0 }
+	};
+	struct ColumnReach Reach[BATCH_COLUMN_CAPACITY];
+	int32_t Boost[BATCH_CHUNK_SIZE];
+	uint32_t Playing = 0, Game, i;
+
+	for (Game = First; Game < First + Count; Game++)
+		if (Batch->Playing[Game])
+			Playing++;
+
+	while (Playing > 0 && Columns.Time < Batch->MaxTime)
+	{
+		memset(Boost, 0, sizeof(Boost));
+		if (Controller != NULL)
+			Controller(Batch, &Columns, First, Count, Boost, Data);
+
+		Columns.Time++;
+		AdvanceColumns(Batch, &Columns, First, Count);
+		uint32_t ReachCount = GetColumnsInReach(&Columns, Reach);
+
+		for (Game = First; Game < First + Count; Game += 4)
+		{
+			uint32_t BorderMask;
+			uint32_t Mask = StepPlayers4(Batch, Game, &Boost[Game - First], Reach, ReachCount, &BorderMask);
+			if (Mask == 0)
+				continue;
+			for (i = 0; i < 4; i++)
+				if (Mask & (1 << i))
+				{
+					Batch->Playing[Game + i] = 0;
+					Batch->Time[Game + i] = Columns.Time;
+					Batch->GameOverReason[Game + i] = (BorderMask & (1 << i))
+						? FIELD_BORDER_COLLISION : RECTANGLE_COLLISION;
+					Playing--;
+				}
+		}
+	}
+
+	for (Game = First; Game < First + Count; Game++)
+		if (Batch->Playing[Game])
+			Batch->Time[Game] = Columns.Time;
+}
+
+static void* BatchThread(void* Arg)
+{
+	struct BatchRun* Run = Arg;
+	uint32_t Chunk;
+	while ((Chunk = __sync_fetch_and_add(&Run->NextChunk, 1)) < (Run->Batch->Stride + BATCH_CHUNK_SIZE - 1) / BATCH_CHUNK_SIZE)
+	{
+		uint32_t First = Chunk * BATCH_CHUNK_SIZE, Count = Run->Batch->Stride - First;
+		if (Count > BATCH_CHUNK_SIZE)
+			Count = BATCH_CHUNK_SIZE;
+		PlayChunk(Run->Batch, First, Count, Run->Controller, Run->Data);
+	}
+	return NULL;
+}
+
+uint32_t RunGameBatch(struct GameBatch* Batch, uint32_t Threads, TBatchController Controller, void* Data)
+{
+	struct BatchRun Run = {
+		.Batch = Batch,
+		.Controller = Controller,
+		.Data = Data,
+		.NextChunk = 0
+	};
+	uint32_t Chunks = (Batch->Stride + BATCH_CHUNK_SIZE - 1) / BATCH_CHUNK_SIZE, Started = 0, i;
+
+	if (Threads == 0)
+	{
+		long Processors = sysconf(_SC_NPROCESSORS_ONLN);
+		Threads = Processors > 0 ? (uint32_t) Processors : 1;
+	}
+	if (Threads > Chunks)
+		Threads = Chunks;
+
+	// This thread plays chunks too. If threads can't be created, the ones
+	// that could be, and this one, play all of the chunks anyway.
+	pthread_t* Handles = NULL;
+	if (Threads > 1 && (Handles = malloc((Threads - 1) * sizeof(pthread_t))) != NULL)
+		for (i = 0; i < Threads - 1; i++)
+			if (pthread_create(&Handles[Started], NULL, BatchThread, &Run) == 0)
+				Started++;
+	BatchThread(&Run);
+	for (i = 0; i < Started; i++)
+		pthread_join(Handles[i], NULL);
+	free(Handles);
+	return Started + 1;
+}
+
+bool InitializeGameBatch(struct GameBatch* Batch, uint32_t Count, uint32_t MaxTime, uint64_t Seed,
+	const struct GameParameters* Parameters)
+{
+	uint32_t i;
+
+	Batch->Count = Count;
+	Batch->Parameters = *Parameters;
+	Batch->Stride = (Count + 3) & ~3;
+	Batch->MaxTime = MaxTime;
+	Batch->PlayerY        = malloc(Batch->Stride * sizeof(fixed));
+	Batch->PlayerSpeed    = malloc(Batch->Stride * sizeof(fixed));
+	Batch->Playing        = malloc(Batch->Stride * sizeof(int32_t));
+	Batch->Score          = malloc(Batch->Stride * sizeof(uint32_t));
+	Batch->Time           = malloc(Batch->Stride * sizeof(uint32_t));
+	Batch->GameOverReason = malloc(Batch->Stride * sizeof(enum GameOverReason));
+	Batch->Gaps           = malloc(Batch->Stride * sizeof(struct GapGenerator));
+	Batch->GapTop         = calloc(BATCH_COLUMN_CAPACITY * Batch->Stride, sizeof(fixed));
+	if (Batch->PlayerY == NULL || Batch->PlayerSpeed == NULL
+	 || Batch->Playing == NULL || Batch->Score == NULL || Batch->Time == NULL
+	 || Batch->GameOverReason == NULL || Batch->Gaps == NULL || Batch->GapTop == NULL)
+	{
+		FinalizeGameBatch(Batch);
+		return false;
+	}
+
+	for (i = 0; i < Batch->Stride; i++)
+	{
+		Batch->PlayerY[i] = FIXED_PLAYER_START_Y;
+		Batch->PlayerSpeed[i] = 0;
+		Batch->Playing[i] = i < Count ? -1 : 0;
+		Batch->Score[i] = 0;
+		Batch->Time[i] = 0;
+		Batch->GameOverReason[i] = FIELD_BORDER_COLLISION;
+		InitializeGapGenerator(&Batch->Gaps[i], Seed + i, Parameters);
+	}
+	return true;
+}
+
+void FinalizeGameBatch(struct GameBatch* Batch)
+{
+	free(Batch->PlayerY);
+	free(Batch->PlayerSpeed);
+	free(Batch->Playing);
+	free(Batch->Score);
+	free(Batch->Time);
+	free(Batch->GameOverReason);
+	free(Batch->Gaps);
+	free(Batch->GapTop);
+	Batch->PlayerY = Batch->PlayerSpeed = Batch->GapTop = NULL;
+	Batch->Playing = NULL;
+	Batch->Score = Batch->Time = NULL;
+	Batch->GameOverReason = NULL;
+	Batch->Gaps = NULL;
+	Batch->Count = Batch->Stride = 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Hocoslamfy, batch simulation header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed.h"
+#include "sim.h"
+#include "events.h"
+
+// A batch of independent games, played in lockstep one millisecond at a time
+// with the rules of AdvanceGameState.
+// Where the columns are and when they appear only depends on time, so at any
+// given millisecond, every game of a batch has its columns at the same
+// horizontal positions; only the heights of their gaps differ. The columns'
+// positions are therefore kept once, and each game only has its player and
+// the tops of its gaps, in one array per member, so that 4 games can be
+// stepped at a time.
+// A game stops being played when its player collides with something, since
+// nothing after that changes its outcome.
+
+// The number of games that are played together by one thread.
+#define BATCH_CHUNK_SIZE      256
+
+// The number of columns that can be on the field at once. It must be a power
+// of 2, and the field has room for at most 8 (see RECTANGLE_CAPACITY).
+#define BATCH_COLUMN_CAPACITY 16
+
+// The columns on the field, which are shared by all games of a chunk.
+// Each column is a pair of rectangles from Left to Left + FIXED_RECT_WIDTH,
+// one above and one below the gap. The columns are in a circular buffer
+// indexed from Start; Cursor is the index of the first column that may still
+// be within reach of the player.
+struct BatchColumns
+{
+	fixed    Left[BATCH_COLUMN_CAPACITY];
+	uint32_t Start;
+	uint32_t Count;
+	uint32_t Cursor;
+	fixed    GenDistance;
+	// The number of milliseconds played so far.
+	uint32_t Time;
+	// When the columns go past the player and the left side, in Time (see
+	// events.h).
+	struct FieldEventQueue Events;
+};
+
+struct GameBatch
+{
+	// The number of games in the batch, and the same, rounded up to a multiple
+	// of 4; the extra games are never played.
+	uint32_t             Count;
+	uint32_t             Stride;
+	// The number of milliseconds after which games that are still being
+	// played are stopped.
+	uint32_t             MaxTime;
+	// The parameters all games of the batch are played with.
+	struct GameParameters Parameters;
+
+	// Per game:
+	fixed*               PlayerY;
+	fixed*               PlayerSpeed;
+	// All bits set while the game is being played; 0 after.
+	int32_t*             Playing;
+	uint32_t*            Score;
+	// The number of milliseconds the game was played for.
+	uint32_t*            Time;
+	enum GameOverReason* GameOverReason;
+	// The generator of the gaps of the game's columns.
+	struct GapGenerator* Gaps;
+
+	// The tops of the gaps of each game's columns. The one for the column in
+	// slot S of BatchColumns for game G is at [S * Stride + G].
+	fixed*               GapTop;
+};
+
+// Decides whether the player of each of the Count games starting at First
+// boosts during the next millisecond, and writes non-zero to Boost[i] for
+// game First + i if so. Data is passed through from RunGameBatch.
+// This is called from several threads at once, for different games.
+typedef void (*TBatchController) (const struct GameBatch* Batch, const struct BatchColumns* Columns,
+	uint32_t First, uint32_t Count, int32_t* Boost, void* Data);
+
+// Allocates a batch of Count games, each stopped after MaxTime milliseconds
+// and played with the given parameters, which CheckGameParameters must
+// accept. Game i has the same gaps as a game started with ResetGameState with
+// the seed Seed + i and the same parameters.
+// Returns false if memory could not be allocated.
+extern bool InitializeGameBatch(struct GameBatch* Batch, uint32_t Count, uint32_t MaxTime, uint64_t Seed,
+	const struct GameParameters* Parameters);
+
+extern void FinalizeGameBatch(struct GameBatch* Batch);
+
+// Plays all games of a batch to the end, split into chunks of
+// BATCH_CHUNK_SIZE games that are handed out to Threads threads, or to as
+// many threads as there are processors if Threads is 0.
+// Returns the number of threads used.
+extern uint32_t RunGameBatch(struct GameBatch* Batch, uint32_t Threads, TBatchController Controller, void* Data);
+
+// Returns the slot in BatchColumns of the Index-th column on the field, from
+// left to right.
+extern uint32_t BatchColumnSlot(const struct BatchColumns* Columns, uint32_t Index);
+
+// A simple bot for batches: boosts the player whenever it's well below the
+// middle of the gap of the next column, and not already rising. If Data is
+// not NULL, it's an array of fixed-point heights, one per game of the batch,
+// that are added to where the bot aims in each game.
+extern void BatchAutopilotController(const struct GameBatch* Batch, const struct BatchColumns* Columns,
+	uint32_t First, uint32_t Count, int32_t* Boost, void* Data);
+
+#endif /* !defined(_BATCH_H_) */
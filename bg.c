@@ -18,6 +18,11 @@
  */
 
 #include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
 
 #include "SDL.h"
 
@@ -25,6 +30,9 @@
 #include "init.h"
 #include "game.h"
 #include "bg.h"
+#include "dirty.h"
+#include "sprite.h"
+#include "strip.h"
 
 // The X coordinates from which the various layers of the background start to
 // be rendered. (In meters.)
@@ -32,6 +40,9 @@ static       float    BG_X     [BG_LAYER_COUNT] = {
 	0.0f, 0.0f, 0.0f, 0.0f,
 	0.0f, 0.0f, 0.0f, 0.0f
 };
+// Where the layers were at the previous logic tick, from which they're drawn
+// FrameInterpolation of the way to BG_X, like the columns. (In meters.)
+static       float    BG_PreviousX[BG_LAYER_COUNT];
 // The speed at which the X coordinate moves, for each piece of the background.
 // (In meters per second.)
 static const float    BG_Speed [BG_LAYER_COUNT] = {
@@ -39,43 +50,246 @@ static const float    BG_Speed [BG_LAYER_COUNT] = {
 	BG_SPEED_5, BG_SPEED_3, BG_SPEED_4, BG_SPEED_5
 };
 
-// The Y coordinates at which the various layers of the background start, and
-// their heights, on the screen. (In pixels of the screen.)
-static const uint32_t BG_StartY[BG_LAYER_COUNT] = {
-	/* "Sky.png", "Mountains.png", "Clouds3.png", "Clouds2.png",
-	 * "Clouds1.png", "Grass3.png", "Grass2.png", "Grass1.png" */
-	 50, 128,  32,  16,
-	  0, 180, 190, 204
-};
-static const uint32_t BG_Height[BG_LAYER_COUNT] = {
-	140,  60,  28,  28,
-	 32,  20,  28,  36
+// A strip cut by CutBackground (see strip.h), with the image it's drawn from.
+struct BackgroundStrip
+{
+	// The layer whose rows these are, and whose X they're drawn from.
+	uint32_t     Layer;
+	// The image holding the rows, and the first of them in it. Opaque rows of
+	// layers with alpha get their own image; the others use the layer's.
+	SDL_Surface* Image;
+	uint32_t     SourceY;
+	bool         Opaque;
+	// Where the rows are on the screen. (In pixels of the screen.)
+	uint32_t     StartY;
+	uint32_t     Height;
 };
 
+static struct BackgroundStrip BG_Strip[MAX_BG_STRIPS];
+// Span sprites of the layers with alpha, from which strips that aren't
+// opaque are blitted.
+static struct SpanSprite*     BG_LayerSprite[BG_LAYER_COUNT];
+static uint32_t               BG_StripCount = 0;
+
+// Where each strip was drawn, and from which X in its image.
+static struct ScreenSprite    BG_Sprite[MAX_BG_STRIPS];
+
 void AdvanceBackground(uint32_t Milliseconds)
 {
 	uint32_t i;
+	memcpy(BG_PreviousX, BG_X, sizeof(BG_X));
 	for (i = 0; i < BG_LAYER_COUNT; i++)
 	{
 		BG_X[i] = fmodf(BG_X[i] + BG_Speed[i] * Milliseconds / 1000, FIELD_WIDTH * 0.5f);
 	}
 }
 
-void DrawBackground(void)
+void SaveBackground(float X[BG_LAYER_COUNT])
+{
+	memcpy(X, BG_X, sizeof(BG_X));
+}
+
+void LoadBackground(const float X[BG_LAYER_COUNT])
+{
+	memcpy(BG_X, X, sizeof(BG_X));
+	memcpy(BG_PreviousX, X, sizeof(BG_X));
+}
+
+void HoldBackground(void)
+{
+	memcpy(BG_PreviousX, BG_X, sizeof(BG_X));
+}
+
+// Returns the X in the image of a layer from which it's drawn. (In pixels.)
+static int GetSourceX(uint32_t Layer)
+{
+	float Wrap = FIELD_WIDTH * 0.5f, Moved = BG_X[Layer] - BG_PreviousX[Layer];
+	// A layer that wrapped around during the tick moved forward all the same.
+	if (Moved < 0)
+		Moved += Wrap;
+	float X = BG_X[Layer] - (1.0f - FrameInterpolation) * Moved;
+	if (X < 0)
+		X += Wrap;
+	return (int) (X * SCREEN_WIDTH / FIELD_WIDTH);
+}
+
+// Returns whether a row of an image has no transparency at all.
+static bool IsRowOpaque(const SDL_Surface* Image, uint32_t Y)
+{
+	const Uint32 Amask = Image->format->Amask;
+	const Uint32* Row = (const Uint32*) ((const Uint8*) Image->pixels + Y * Image->pitch);
+	int x;
+
+	if (Image->flags & SDL_SRCCOLORKEY)
+	{
+		for (x = 0; x < Image->w; x++)
+			if (Row[x] == Image->format->colorkey)
+				return false;
+		return true;
+	}
+	if (Amask == 0)
+		return true;
+	for (x = 0; x < Image->w; x++)
+		if ((Row[x] & Amask) != Amask)
+			return false;
+	return true;
+}
+
+// Makes a copy of rows of an image, without alpha, in the screen's format.
+static SDL_Surface* CopyOpaqueRows(SDL_Surface* Image, uint32_t Y, uint32_t Height)
+{
+	const SDL_PixelFormat* Format = Image->format;
+	SDL_Surface* Rows;
+	SDL_Surface* Result = NULL;
+
+	// The image's pixels are only there while it's locked, because SDL may
+	// free those of a surface that it run-length encodes.
+	if (SDL_MUSTLOCK(Image))
+		SDL_LockSurface(Image);
+	Rows = SDL_CreateRGBSurfaceFrom((Uint8*) Image->pixels + Y * Image->pitch,
+		Image->w, Height, Format->BitsPerPixel, Image->pitch,
+		Format->Rmask, Format->Gmask, Format->Bmask, 0);
+	if (Rows != NULL)
+	{
+		Result = SDL_DisplayFormat(Rows);
+		SDL_FreeSurface(Rows);
+	}
+	if (SDL_MUSTLOCK(Image))
+		SDL_UnlockSurface(Image);
+	return Result;
+}
+
+static bool AddStrip(const struct LayerStrip* Rows)
+{
+	struct BackgroundStrip* Strip = &BG_Strip[BG_StripCount];
+
+	Strip->Layer = Rows->Layer;
+	Strip->Opaque = Rows->Opaque;
+	if (Rows->Opaque && BackgroundImages[Rows->Layer]->format->Amask != 0)
+	{
+		Strip->Image = CopyOpaqueRows(BackgroundImages[Rows->Layer], Rows->SourceY, Rows->Height);
+		Strip->SourceY = 0;
+		if (Strip->Image == NULL)
+		{
+			printf("PrepareBackground failed: %s\n", SDL_GetError());
+			SDL_ClearError();
+			return false;
+		}
+	}
+	else
+	{
+		Strip->Image = BackgroundImages[Rows->Layer];
+		Strip->SourceY = Rows->SourceY;
+	}
+	Strip->StartY = Rows->StartY;
+	Strip->Height = Rows->Height;
+	BG_StripCount++;
+	return true;
+}
+
+bool PrepareBackground(void)
+{
+	bool Opaque[BG_LAYER_COUNT][SCREEN_HEIGHT];
+	struct LayerStrip Strips[MAX_BG_STRIPS];
+	uint32_t Count, i, y;
+	bool Result = true;
+
+	FreeBackground();
+	for (i = 0; i < BG_LAYER_COUNT; i++)
+		if (BackgroundImages[i]->format->Amask != 0)
+		{
+			char Name[32];
+			snprintf(Name, sizeof(Name), "background layer %" PRIu32, i);
+			if ((BG_LayerSprite[i] = CreateSpanSprite(BackgroundImages[i], Name)) == NULL)
+			{
+				FreeBackground();
+				return false;
+			}
+		}
+	for (i = 0; i < BG_LAYER_COUNT; i++)
+	{
+		SDL_Surface* Image = BackgroundImages[i];
+		if (SDL_MUSTLOCK(Image))
+			SDL_LockSurface(Image);
+		for (y = 0; y < BG_Height[i] && BG_StartY[i] + y < SCREEN_HEIGHT; y++)
+			Opaque[i][y] = IsRowOpaque(Image, y);
+		if (SDL_MUSTLOCK(Image))
+			SDL_UnlockSurface(Image);
+	}
+
+	Count = CutBackground(Opaque, Strips);
+	if (Count > MAX_BG_STRIPS)
+	{
+		printf("PrepareBackground failed: more than %u strips\n", MAX_BG_STRIPS);
+		Result = false;
+	}
+	for (i = 0; i < Count && Result; i++)
+		Result = AddStrip(&Strips[i]);
+
+	if (Result)
+	{
+		uint32_t OpaqueRows = 0, BlendedRows = 0;
+		for (i = 0; i < BG_StripCount; i++)
+		{
+			if (BG_Strip[i].Opaque)
+				OpaqueRows += BG_Strip[i].Height;
+			else
+				BlendedRows += BG_Strip[i].Height;
+		}
+		printf("Background prepared: %u strips, %u opaque rows, %u blended rows\n", BG_StripCount, OpaqueRows, BlendedRows);
+	}
+	else
+		FreeBackground();
+	return Result;
+}
+
+void FreeBackground(void)
 {
 	uint32_t i;
+	for (i = 0; i < BG_StripCount; i++)
+		if (BG_Strip[i].Image != BackgroundImages[BG_Strip[i].Layer])
+			SDL_FreeSurface(BG_Strip[i].Image);
 	for (i = 0; i < BG_LAYER_COUNT; i++)
+	{
+		FreeSpanSprite(BG_LayerSprite[i]);
+		BG_LayerSprite[i] = NULL;
+	}
+	memset(BG_Sprite, 0, sizeof(BG_Sprite));
+	BG_StripCount = 0;
+}
+
+void UpdateBackgroundSprites(void)
+{
+	uint32_t i;
+	for (i = 0; i < BG_StripCount; i++)
+	{
+		SDL_Rect DestRect = {
+			.x = 0,
+			.y = BG_Strip[i].StartY,
+			.w = SCREEN_WIDTH,
+			.h = BG_Strip[i].Height };
+		UpdateSprite(&BG_Sprite[i], &DestRect, (uint32_t) GetSourceX(BG_Strip[i].Layer));
+	}
+}
+
+void DrawBackground(void)
+{
+	uint32_t i;
+	for (i = 0; i < BG_StripCount; i++)
 	{
 		SDL_Rect SourceRect = {
-			.x = (int) (BG_X[i] * SCREEN_WIDTH / FIELD_WIDTH),
-			.y = 0,
+			.x = GetSourceX(BG_Strip[i].Layer),
+			.y = BG_Strip[i].SourceY,
 			.w = SCREEN_WIDTH,
-			.h = BG_Height[i] };
+			.h = BG_Strip[i].Height };
 		SDL_Rect DestRect = {
 			.x = 0,
-			.y = BG_StartY[i],
+			.y = BG_Strip[i].StartY,
 			.w = SCREEN_WIDTH,
-			.h = BG_Height[i] };
-		SDL_BlitSurface(BackgroundImages[i], &SourceRect, Screen, &DestRect);
+			.h = BG_Strip[i].Height };
+		if (!BG_Strip[i].Opaque && BG_LayerSprite[BG_Strip[i].Layer] != NULL)
+			BlitSpanSprite(BG_LayerSprite[BG_Strip[i].Layer], &SourceRect, Screen, &DestRect);
+		else
+			SDL_BlitSurface(BG_Strip[i].Image, &SourceRect, Screen, &DestRect);
 	}
 }
@@ -20,6 +20,7 @@
 #ifndef _BG_H_
 #define _BG_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "game.h"
@@ -33,6 +34,26 @@
 #define BG_SPEED_5     (-FIELD_SCROLL * 1 / 2)
 
 extern void AdvanceBackground(uint32_t Milliseconds);
+
+// Copies where each layer of the background is scrolled to into X, or back
+// from X. A background that was loaded isn't interpolated until it advances.
+extern void SaveBackground(float X[BG_LAYER_COUNT]);
+extern void LoadBackground(const float X[BG_LAYER_COUNT]);
+
+// Makes the background be drawn where it is, without interpolating from the
+// previous logic tick, for ticks in which it didn't advance.
+extern void HoldBackground(void);
+
+// Cuts the layers of the background, loaded into BackgroundImages in the
+// screen's pixel format, into the strips that DrawBackground draws. Returns
+// false and prints why on failure.
+extern bool PrepareBackground(void);
+// Frees the strips, before BackgroundImages are.
+extern void FreeBackground(void);
+
+// Marks the strips of the background that moved by a pixel or more since the
+// last frame as changed (see dirty.h). Call before DrawBackground.
+extern void UpdateBackgroundSprites(void);
 extern void DrawBackground(void);
 
 #endif /* !defined(_BG_H_) */
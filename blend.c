@@ -0,0 +1,141 @@
+/*
+ * Hocoslamfy, alpha blending code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// AVX2 is used if the processor has it, even if the compiler doesn't target
+// it for the rest of the program.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+ && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9) || defined(__clang__))
+#define BLEND_AVX2
+#include <immintrin.h>
+#endif
+
+#include "blend.h"
+
+void PremultiplyPixels(uint32_t* Pixels, uint32_t Count)
+{
+	uint32_t i;
+	for (i = 0; i < Count; i++)
+	{
+		uint32_t P = Pixels[i], Alpha = P >> 24;
+		if (Alpha == 0xFF)
+			continue;
+		Pixels[i] = (P & 0xFF000000)
+		          | ((((P & 0xFF00FF) * Alpha) >> 8) & 0xFF00FF)
+		          | ((((P & 0xFF00) * Alpha) >> 8) & 0xFF00);
+	}
+}
+
+// Each of red and blue, then green and alpha, are multiplied in their own 16
+// bits, where they can't overflow into each other, and the sum can't carry
+// out of any byte.
+static void BlendScalar(uint32_t* Dest, const uint32_t* Source, uint32_t Count)
+{
+	uint32_t i;
+	for (i = 0; i < Count; i++)
+	{
+		uint32_t S = Source[i], D = Dest[i], Factor = 256 - (S >> 24);
+		uint32_t RB = (((D & 0xFF00FF) * Factor) >> 8) & 0xFF00FF,
+		         AG = (((D >> 8) & 0xFF00FF) * Factor) & 0xFF00FF00;
+		Dest[i] = S + RB + AG;
+	}
+}
+
+#ifdef __SSE2__
+static void BlendSSE2(uint32_t* Dest, const uint32_t* Source, uint32_t Count)
+{
+	const __m128i Zero = _mm_setzero_si128(), Full = _mm_set1_epi32(256);
+	uint32_t i;
+	for (i = 0; i + 4 <= Count; i += 4)
+	{
+		__m128i S = _mm_loadu_si128((const __m128i*) &Source[i]),
+		        D = _mm_loadu_si128((const __m128i*) &Dest[i]);
+		// 256 - Alpha in both halves of each pixel, then in all 4 bytes
+		// widened to 16 bits.
+		__m128i Factor = _mm_sub_epi32(Full, _mm_srli_epi32(S, 24));
+		Factor = _mm_or_si128(Factor, _mm_slli_epi32(Factor, 16));
+		__m128i Low = _mm_mullo_epi16(_mm_unpacklo_epi8(D, Zero), _mm_unpacklo_epi32(Factor, Factor)),
+		        High = _mm_mullo_epi16(_mm_unpackhi_epi8(D, Zero), _mm_unpackhi_epi32(Factor, Factor));
+		D = _mm_packus_epi16(_mm_srli_epi16(Low, 8), _mm_srli_epi16(High, 8));
+		_mm_storeu_si128((__m128i*) &Dest[i], _mm_add_epi8(S, D));
+	}
+	BlendScalar(&Dest[i], &Source[i], Count - i);
+}
+#endif /* defined(__SSE2__) */
+
+#ifdef BLEND_AVX2
+// The same as BlendSSE2, 8 pixels at a time. The unpacks and packs work
+// within each 128-bit half, so pixels stay in order.
+__attribute__((target("avx2")))
+static void BlendAVX2(uint32_t* Dest, const uint32_t* Source, uint32_t Count)
+{
+	const __m256i Zero = _mm256_setzero_si256(), Full = _mm256_set1_epi32(256);
+	uint32_t i;
+	for (i = 0; i + 8 <= Count; i += 8)
+	{
+		__m256i S = _mm256_loadu_si256((const __m256i*) &Source[i]),
+		        D = _mm256_loadu_si256((const __m256i*) &Dest[i]);
+		__m256i Factor = _mm256_sub_epi32(Full, _mm256_srli_epi32(S, 24));
+		Factor = _mm256_or_si256(Factor, _mm256_slli_epi32(Factor, 16));
+		__m256i Low = _mm256_mullo_epi16(_mm256_unpacklo_epi8(D, Zero), _mm256_unpacklo_epi32(Factor, Factor)),
+		        High = _mm256_mullo_epi16(_mm256_unpackhi_epi8(D, Zero), _mm256_unpackhi_epi32(Factor, Factor));
+		D = _mm256_packus_epi16(_mm256_srli_epi16(Low, 8), _mm256_srli_epi16(High, 8));
+		_mm256_storeu_si256((__m256i*) &Dest[i], _mm256_add_epi8(S, D));
+	}
+	BlendScalar(&Dest[i], &Source[i], Count - i);
+}
+#endif /* defined(BLEND_AVX2) */
+
+static struct BlendKernel Kernels[3];
+static uint32_t           KernelCount = 0;
+
+uint32_t GetBlendKernels(const struct BlendKernel** Result)
+{
+	if (KernelCount == 0)
+	{
+		Kernels[KernelCount++] = (struct BlendKernel) { "scalar", BlendScalar };
+#ifdef __SSE2__
+		Kernels[KernelCount++] = (struct BlendKernel) { "SSE2", BlendSSE2 };
+#endif
+#ifdef BLEND_AVX2
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			Kernels[KernelCount++] = (struct BlendKernel) { "AVX2", BlendAVX2 };
+#endif
+	}
+	*Result = Kernels;
+	return KernelCount;
+}
+
+void BlendPixels(uint32_t* Dest, const uint32_t* Source, uint32_t Count)
+{
+	static TBlendKernel Blend = NULL;
+	if (Blend == NULL)
+	{
+		const struct BlendKernel* Available;
+		uint32_t KernelsAvailable = GetBlendKernels(&Available);
+		Blend = Available[KernelsAvailable - 1].Blend;
+	}
+	Blend(Dest, Source, Count);
+}
@@ -0,0 +1,53 @@
+/*
+ * Hocoslamfy, alpha blending header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _BLEND_H_
+#define _BLEND_H_
+
+#include <stdint.h>
+
+// Blending of 32-bit pixels with alpha in the top byte over others, as in
+// the screen's pixel format, with colors premultiplied by alpha beforehand.
+// Each byte of a blended pixel is
+//   Source + Dest * (256 - Alpha) / 256,
+// which is within 1 of what SDL 1.2 gives for the pixels before they were
+// premultiplied, and the same whichever kernel does it.
+
+// Premultiplies the colors of pixels by their alpha, in place. Opaque pixels
+// are left alone, so that blending them copies them.
+extern void PremultiplyPixels(uint32_t* Pixels, uint32_t Count);
+
+// Blends Count premultiplied pixels from Source over Dest, with the fastest
+// kernel the processor can run.
+extern void BlendPixels(uint32_t* Dest, const uint32_t* Source, uint32_t Count);
+
+typedef void (*TBlendKernel) (uint32_t* Dest, const uint32_t* Source, uint32_t Count);
+
+struct BlendKernel
+{
+	const char*  Name;
+	TBlendKernel Blend;
+};
+
+// Points *Kernels to the kernels that this build has and that the processor
+// can run, the portable one first and the fastest one last, and returns how
+// many there are.
+extern uint32_t GetBlendKernels(const struct BlendKernel** Kernels);
+
+#endif /* !defined(_BLEND_H_) */
@@ -0,0 +1,180 @@
+/*
+ * Hocoslamfy, seed catalog code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "catalog.h"
+
+static const char CatalogMagic[4] = { 'H', 'C', 'S', 'C' };
+
+#define CATALOG_HEADER_SIZE 16
+
+const uint32_t CatalogCheckpoints[CATALOG_CHECKPOINTS] = { 10, 25, 50, 100 };
+
+static void PutNumber(uint8_t* Bytes, uint64_t Value, uint32_t Size)
+{
+	uint32_t i;
+	for (i = 0; i < Size; i++)
+		Bytes[i] = (uint8_t) (Value >> (i * 8));
+}
+
+static uint64_t GetNumber(const uint8_t* Bytes, uint32_t Size)
+{
+	uint64_t Value = 0;
+	uint32_t i;
+	for (i = 0; i < Size; i++)
+		Value |= (uint64_t) Bytes[i] << (i * 8);
+	return Value;
+}
+
+// Returns the slot at which to start looking for a seed in a table of
+// SlotCount slots, which is a power of 2.
+static uint32_t CatalogSlot(uint64_t Seed, uint32_t SlotCount)
+{
+	return (uint32_t) ((Seed * UINT64_C(0x9E3779B97F4A7C15)) >> 32) & (SlotCount - 1);
+}
+
+static void PackRating(uint8_t* Record, const struct SeedRating* Rating)
+{
+	uint32_t i;
+	memset(Record, 0, CATALOG_RECORD_SIZE);
+	PutNumber(Record,      Rating->Seed, 8);
+	PutNumber(Record + 8,  Rating->Plays, 4);
+	PutNumber(Record + 12, Rating->MeanScore, 4);
+	PutNumber(Record + 16, Rating->MedianScore, 2);
+	PutNumber(Record + 18, Rating->Difficulty, 2);
+	for (i = 0; i < CATALOG_CHECKPOINTS; i++)
+		PutNumber(Record + 20 + i * 2, Rating->Survival[i], 2);
+}
+
+static void UnpackRating(const uint8_t* Record, struct SeedRating* Rating)
+{
+	uint32_t i;
+	Rating->Seed        = GetNumber(Record, 8);
+	Rating->Plays       = (uint32_t) GetNumber(Record + 8, 4);
+	Rating->MeanScore   = (uint32_t) GetNumber(Record + 12, 4);
+	Rating->MedianScore = (uint16_t) GetNumber(Record + 16, 2);
+	Rating->Difficulty  = (uint16_t) GetNumber(Record + 18, 2);
+	for (i = 0; i < CATALOG_CHECKPOINTS; i++)
+		Rating->Survival[i] = (uint16_t) GetNumber(Record + 20 + i * 2, 2);
+}
+
+bool SaveSeedCatalog(const struct SeedRating* Ratings, uint32_t Count, const char* Path)
+{
+	uint8_t Header[CATALOG_HEADER_SIZE];
+	// At most half of the slots are used, so that seeds are rarely far from
+	// where they're looked for.
+	uint32_t SlotCount = 1, i;
+	while (SlotCount < 2 * Count)
+		SlotCount *= 2;
+
+	uint8_t* Slots = calloc(SlotCount, CATALOG_RECORD_SIZE);
+	if (Slots == NULL)
+	{
+		fprintf(stderr, "%s: Out of memory.\n", Path);
+		return false;
+	}
+	for (i = 0; i < Count; i++)
+	{
+		uint32_t Slot = CatalogSlot(Ratings[i].Seed, SlotCount);
+		while (GetNumber(Slots + Slot * CATALOG_RECORD_SIZE + 8, 4) != 0)
+			Slot = (Slot + 1) & (SlotCount - 1);
+		PackRating(Slots + Slot * CATALOG_RECORD_SIZE, &Ratings[i]);
+	}
+
+	FILE* fp = fopen(Path, "wb");
+	if (!fp)
+	{
+		fprintf(stderr, "%s: Unable to open file.\n", Path);
+		free(Slots);
+		return false;
+	}
+	memcpy(Header, CatalogMagic, sizeof(CatalogMagic));
+	PutNumber(Header + 4,  CATALOG_VERSION, 4);
+	PutNumber(Header + 8,  SlotCount, 4);
+	PutNumber(Header + 12, Count, 4);
+	fwrite(Header, 1, sizeof(Header), fp);
+	fwrite(Slots, CATALOG_RECORD_SIZE, SlotCount, fp);
+	free(Slots);
+
+	bool Result = !ferror(fp);
+	if (fclose(fp) != 0)
+		Result = false;
+	if (!Result)
+		fprintf(stderr, "%s: Unable to write file.\n", Path);
+	return Result;
+}
+
+bool FindSeedRating(const char* Path, uint64_t Seed, struct SeedRating* Rating)
+{
+	uint8_t Header[CATALOG_HEADER_SIZE], Record[CATALOG_RECORD_SIZE];
+	FILE* fp = fopen(Path, "rb");
+
+	if (!fp)
+	{
+		fprintf(stderr, "%s: Unable to open file.\n", Path);
+		return false;
+	}
+	uint32_t SlotCount = 0;
+	if (fread(Header, 1, sizeof(Header), fp) == sizeof(Header)
+	 && memcmp(Header, CatalogMagic, sizeof(CatalogMagic)) == 0)
+		SlotCount = (uint32_t) GetNumber(Header + 8, 4);
+	if (SlotCount == 0 || (SlotCount & (SlotCount - 1)) != 0)
+	{
+		fprintf(stderr, "%s: Not a seed catalog.\n", Path);
+		fclose(fp);
+		return false;
+	}
+	if (GetNumber(Header + 4, 4) != CATALOG_VERSION)
+	{
+		fprintf(stderr, "%s: Unsupported seed catalog version %u.\n", Path, (unsigned int) GetNumber(Header + 4, 4));
+		fclose(fp);
+		return false;
+	}
+
+	uint32_t Slot = CatalogSlot(Seed, SlotCount), Probes;
+	bool Found = false;
+	for (Probes = 0; Probes < SlotCount; Probes++)
+	{
+		// Slots after the one looked at are read without seeking.
+		if ((Probes == 0 || Slot == 0)
+		 && fseek(fp, CATALOG_HEADER_SIZE + (long) Slot * CATALOG_RECORD_SIZE, SEEK_SET) != 0)
+			break;
+		if (fread(Record, 1, sizeof(Record), fp) != sizeof(Record))
+		{
+			fprintf(stderr, "%s: Truncated seed catalog.\n", Path);
+			break;
+		}
+		if (GetNumber(Record + 8, 4) == 0)
+			break;
+		if (GetNumber(Record, 8) == Seed)
+		{
+			UnpackRating(Record, Rating);
+			Found = true;
+			break;
+		}
+		Slot = (Slot + 1) & (SlotCount - 1);
+	}
+	fclose(fp);
+	return Found;
+}
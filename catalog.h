@@ -0,0 +1,67 @@
+/*
+ * Hocoslamfy, seed catalog header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _CATALOG_H_
+#define _CATALOG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A catalog of seeds rated by how well a noisy bot does on them (see
+// tools/hocorate.c), so that seeds can be picked by difficulty ahead of time.
+// In a file, a catalog is the 4 bytes "HCSC" followed by the format version
+// (CATALOG_VERSION), the number of slots and the number of seeds, as 32-bit
+// little-endian numbers, and then the slots. The slots are a hash table
+// indexed by CatalogSlot, with collisions going to the next slot; each is
+// CATALOG_RECORD_SIZE bytes long, and empty ones are all zeroes. A seed can
+// therefore be found by reading a slot or two, however large the catalog is.
+
+#define CATALOG_VERSION     1
+#define CATALOG_RECORD_SIZE 32
+
+// The numbers of columns at which the survival of the bot is recorded.
+#define CATALOG_CHECKPOINTS 4
+extern const uint32_t CatalogCheckpoints[CATALOG_CHECKPOINTS];
+
+struct SeedRating
+{
+	uint64_t Seed;
+	// The number of games the bot played with the seed. Never 0.
+	uint32_t Plays;
+	// The bot's mean score, in hundredths, and its median score.
+	uint32_t MeanScore;
+	uint16_t MedianScore;
+	// The percentage of seeds in the catalog that the bot did better on
+	// (by mean score). 0 is the easiest seed, and near 100 the hardest.
+	uint16_t Difficulty;
+	// The share of games in which the bot passed at least
+	// CatalogCheckpoints[i] columns, in ten-thousandths.
+	uint16_t Survival[CATALOG_CHECKPOINTS];
+};
+
+// Writes a catalog of Count ratings, whose seeds must all be different, to
+// a file. Returns false, after printing why, if the file could not be written.
+extern bool SaveSeedCatalog(const struct SeedRating* Ratings, uint32_t Count, const char* Path);
+
+// Looks up a seed in the catalog in a file, reading only the slots it could
+// be in. Returns false if it isn't there, or, after printing why, if the file
+// could not be read or isn't a catalog.
+extern bool FindSeedRating(const char* Path, uint64_t Seed, struct SeedRating* Rating);
+
+#endif /* !defined(_CATALOG_H_) */
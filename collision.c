@@ -0,0 +1,137 @@
+/*
+ * Hocoslamfy, collision detection code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "game.h"
+#include "collision.h"
+
+bool CollidesWithRectangle(fixed X, fixed Y, fixed Left, fixed Top, fixed Right, fixed Bottom)
+{
+	return (((Y + COLLISION_A_HALF_HEIGHT > Bottom
+	       && Y + COLLISION_A_HALF_HEIGHT < Top)
+	      || (Y - COLLISION_A_HALF_HEIGHT > Bottom
+	       && Y - COLLISION_A_HALF_HEIGHT < Top))
+	     && ((X - COLLISION_A_HALF_WIDTH > Left
+	       && X - COLLISION_A_HALF_WIDTH < Right)
+	      || (X + COLLISION_A_HALF_WIDTH > Left
+	       && X + COLLISION_A_HALF_WIDTH < Right)))
+	    || (((Y + COLLISION_B_HALF_HEIGHT > Bottom
+	       && Y + COLLISION_B_HALF_HEIGHT < Top)
+	      || (Y - COLLISION_B_HALF_HEIGHT > Bottom
+	       && Y - COLLISION_B_HALF_HEIGHT < Top))
+	     && ((X - COLLISION_B_HALF_WIDTH > Left
+	       && X - COLLISION_B_HALF_WIDTH < Right)
+	      || (X + COLLISION_B_HALF_WIDTH > Left
+	       && X + COLLISION_B_HALF_WIDTH < Right)));
+}
+
+void SetHitboxes(struct Hitboxes* Hitboxes, uint32_t Slot, fixed Left, fixed Top, fixed Right, fixed Bottom)
+{
+	const fixed HalfWidths[2]  = { COLLISION_A_HALF_WIDTH,  COLLISION_B_HALF_WIDTH  };
+	const fixed HalfHeights[2] = { COLLISION_A_HALF_HEIGHT, COLLISION_B_HALF_HEIGHT };
+	uint32_t i;
+	for (i = 0; i < 2; i++)
+	{
+		Hitboxes->Left[i][Slot]  = Left  - HalfWidths[i];
+		Hitboxes->Right[i][Slot] = Right + HalfWidths[i];
+		if (Top > Bottom)
+		{
+			Hitboxes->Top[i][Slot]    = Top    + HalfHeights[i];
+			Hitboxes->Bottom[i][Slot] = Bottom - HalfHeights[i];
+		}
+		else
+			Hitboxes->Top[i][Slot] = Hitboxes->Bottom[i][Slot] = 0;
+	}
+}
+
+uint32_t CollideHitboxes4Scalar(fixed X, fixed Y, const struct Hitboxes* Hitboxes, uint32_t Slot)
+{
+	uint32_t Result = 0, i, j;
+	for (j = 0; j < 4; j++)
+		for (i = 0; i < 2; i++)
+			if (X > Hitboxes->Left[i][Slot + j] && X < Hitboxes->Right[i][Slot + j]
+			 && Y > Hitboxes->Bottom[i][Slot + j] && Y < Hitboxes->Top[i][Slot + j])
+				Result |= 1 << j;
+	return Result;
+}
+
+#ifdef __SSE2__
+
+uint32_t CollideHitboxes4(fixed X, fixed Y, const struct Hitboxes* Hitboxes, uint32_t Slot)
+{
+	__m128i XV = _mm_set1_epi32(X), YV = _mm_set1_epi32(Y), Result = _mm_setzero_si128();
+	uint32_t i;
+	for (i = 0; i < 2; i++)
+	{
+		__m128i Left   = _mm_loadu_si128((const __m128i*) &Hitboxes->Left[i][Slot]);
+		__m128i Top    = _mm_loadu_si128((const __m128i*) &Hitboxes->Top[i][Slot]);
+		__m128i Right  = _mm_loadu_si128((const __m128i*) &Hitboxes->Right[i][Slot]);
+		__m128i Bottom = _mm_loadu_si128((const __m128i*) &Hitboxes->Bottom[i][Slot]);
+		Result = _mm_or_si128(Result, _mm_and_si128(
+			_mm_and_si128(_mm_cmpgt_epi32(XV, Left),   _mm_cmplt_epi32(XV, Right)),
+			_mm_and_si128(_mm_cmpgt_epi32(YV, Bottom), _mm_cmplt_epi32(YV, Top))));
+	}
+	return (uint32_t) _mm_movemask_ps(_mm_castsi128_ps(Result));
+}
+
+void SetAllHitboxes(struct Hitboxes* Hitboxes, uint32_t Count, const fixed* Left, const fixed* Top, const fixed* Right, const fixed* Bottom)
+{
+	const fixed HalfWidths[2]  = { COLLISION_A_HALF_WIDTH,  COLLISION_B_HALF_WIDTH  };
+	const fixed HalfHeights[2] = { COLLISION_A_HALF_HEIGHT, COLLISION_B_HALF_HEIGHT };
+	uint32_t i, Slot;
+	for (Slot = 0; Slot < Count; Slot += 4)
+	{
+		__m128i L = _mm_loadu_si128((const __m128i*) &Left[Slot]);
+		__m128i T = _mm_loadu_si128((const __m128i*) &Top[Slot]);
+		__m128i R = _mm_loadu_si128((const __m128i*) &Right[Slot]);
+		__m128i B = _mm_loadu_si128((const __m128i*) &Bottom[Slot]);
+		__m128i Full = _mm_cmpgt_epi32(T, B);
+		for (i = 0; i < 2; i++)
+		{
+			__m128i Width  = _mm_set1_epi32(HalfWidths[i]);
+			__m128i Height = _mm_set1_epi32(HalfHeights[i]);
+			_mm_storeu_si128((__m128i*) &Hitboxes->Left[i][Slot],   _mm_sub_epi32(L, Width));
+			_mm_storeu_si128((__m128i*) &Hitboxes->Right[i][Slot],  _mm_add_epi32(R, Width));
+			_mm_storeu_si128((__m128i*) &Hitboxes->Top[i][Slot],    _mm_and_si128(Full, _mm_add_epi32(T, Height)));
+			_mm_storeu_si128((__m128i*) &Hitboxes->Bottom[i][Slot], _mm_and_si128(Full, _mm_sub_epi32(B, Height)));
+		}
+	}
+}
+
+#else /* !defined(__SSE2__) */
+
+uint32_t CollideHitboxes4(fixed X, fixed Y, const struct Hitboxes* Hitboxes, uint32_t Slot)
+{
+	return CollideHitboxes4Scalar(X, Y, Hitboxes, Slot);
+}
+
+void SetAllHitboxes(struct Hitboxes* Hitboxes, uint32_t Count, const fixed* Left, const fixed* Top, const fixed* Right, const fixed* Bottom)
+{
+	uint32_t Slot;
+	for (Slot = 0; Slot < Count; Slot++)
+		SetHitboxes(Hitboxes, Slot, Left[Slot], Top[Slot], Right[Slot], Bottom[Slot]);
+}
+
+#endif /* !defined(__SSE2__) */
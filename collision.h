@@ -0,0 +1,79 @@
+/*
+ * Hocoslamfy, collision detection header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _COLLISION_H_
+#define _COLLISION_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed.h"
+#include "game.h"
+
+// The offsets of the edges of the player's collision rectangles from its
+// center, in fixed-point meters.
+#define COLLISION_A_HALF_WIDTH  (FIXED_COLLISION_A_WIDTH  / 2)
+#define COLLISION_A_HALF_HEIGHT (FIXED_COLLISION_A_HEIGHT / 2)
+#define COLLISION_B_HALF_WIDTH  (FIXED_COLLISION_B_WIDTH  / 2)
+#define COLLISION_B_HALF_HEIGHT (FIXED_COLLISION_B_HEIGHT / 2)
+
+// Returns true if the player's collision rectangles A and B, centered on
+// (X, Y), collide with the given rectangle: if an edge of one of them is
+// strictly between the rectangle's edges both horizontally and vertically.
+// This is what a collision is; the hitboxes below give the same results.
+extern bool CollidesWithRectangle(fixed X, fixed Y, fixed Left, fixed Top, fixed Right, fixed Bottom);
+
+// The hitboxes of rectangles, in one array per member and per collision
+// rectangle of the player (0 for A, 1 for B), indexed by slot like the
+// rectangles. The hitbox of a rectangle for A is the rectangle grown by the
+// half-width and half-height of A on all sides (their Minkowski sum), so that
+// A collides with the rectangle when the player's center is strictly inside
+// the hitbox; and likewise for B.
+// That only holds for rectangles taller than A, and wider than A and B, as
+// columns are. A rectangle less than twice as high as B can be straddled by
+// B, which CollidesWithRectangle doesn't count as a collision, but then A,
+// which is wider and shorter, collides with it anyway.
+struct Hitboxes
+{
+	fixed* Left[2];
+	fixed* Top[2];
+	fixed* Right[2];
+	fixed* Bottom[2];
+};
+
+// Sets the hitboxes in a slot to those of the given rectangle. A rectangle
+// with no height gets empty hitboxes.
+extern void SetHitboxes(struct Hitboxes* Hitboxes, uint32_t Slot, fixed Left, fixed Top, fixed Right, fixed Bottom);
+
+// Sets the hitboxes in slots 0 to Count - 1 to those of the rectangles in the
+// same slots of the given arrays, as SetHitboxes does for each. Count is a
+// multiple of 4. Uses SSE2 if the compiler targets it.
+extern void SetAllHitboxes(struct Hitboxes* Hitboxes, uint32_t Count, const fixed* Left, const fixed* Top, const fixed* Right, const fixed* Bottom);
+
+// Tests whether the player's center, (X, Y), is in the hitboxes of the 4
+// slots starting at Slot, which is a multiple of 4. For the rectangles moved
+// horizontally by Scroll, give X - Scroll.
+// Returns a mask in which bit i is set if the player collides with the
+// rectangle in slot Slot + i. Uses SSE2 if the compiler targets it.
+extern uint32_t CollideHitboxes4(fixed X, fixed Y, const struct Hitboxes* Hitboxes, uint32_t Slot);
+// CollideHitboxes4 without SSE2, which is what it is when the compiler
+// doesn't target SSE2.
+extern uint32_t CollideHitboxes4Scalar(fixed X, fixed Y, const struct Hitboxes* Hitboxes, uint32_t Slot);
+
+#endif /* !defined(_COLLISION_H_) */
@@ -0,0 +1,62 @@
+/*
+ * Hocoslamfy, game controller code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+#include "collision.h"
+#include "controller.h"
+
+void GetControllerView(const struct GameState* State, struct ControllerView* View)
+{
+	uint32_t i;
+
+	View->Time = State->Time;
+	View->Score = State->Score;
+	View->PlayerStatus = State->PlayerStatus;
+	View->PlayerX = State->PlayerX;
+	View->PlayerY = State->PlayerY;
+	View->PlayerSpeed = State->PlayerSpeed;
+	View->ColumnCount = 0;
+
+	// Even-numbered rectangle indices are at the top of the field, and the
+	// odd-numbered one after each of them is below it.
+	for (i = 0; i + 1 < State->RectangleCount && View->ColumnCount < CONTROLLER_VIEW_COLUMNS; i += 2)
+	{
+		uint32_t Top = RectangleSlot(State, i), Bottom = RectangleSlot(State, i + 1);
+		if (State->Rectangles.Right[Top] <= State->PlayerX - COLLISION_A_HALF_WIDTH)
+			continue;
+		struct ColumnView* Column = &View->Columns[View->ColumnCount++];
+		Column->Left = State->Rectangles.Left[Top];
+		Column->Right = State->Rectangles.Right[Top];
+		Column->GapBottom = State->Rectangles.Top[Bottom];
+		Column->GapTop = State->Rectangles.Bottom[Top];
+	}
+}
+
+bool AutopilotController(const struct ControllerView* View, void* Data)
+{
+	fixed Target = View->ColumnCount > 0
+		? View->Columns[0].GapBottom + (View->Columns[0].GapTop - View->Columns[0].GapBottom) / 2
+		: FIXED_FIELD_HEIGHT / 2;
+	return View->PlayerStatus == ALIVE
+	    && View->PlayerY < Target - FIXED(0.25)
+	    && View->PlayerSpeed < FIXED(0.5 / 1000);
+}
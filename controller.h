@@ -0,0 +1,64 @@
+/*
+ * Hocoslamfy, game controller header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _CONTROLLER_H_
+#define _CONTROLLER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed.h"
+#include "sim.h"
+
+// The number of columns ahead of the player that a controller can see.
+#define CONTROLLER_VIEW_COLUMNS 4
+
+// A column, made of a rectangle above its gap and one below it.
+struct ColumnView
+{
+	fixed Left;
+	fixed Right;
+	fixed GapBottom;
+	fixed GapTop;
+};
+
+// What a controller (see TController in game.h) is shown of a game before
+// each logic tick.
+struct ControllerView
+{
+	uint32_t          Time;
+	uint32_t          Score;
+	enum PlayerStatus PlayerStatus;
+	fixed             PlayerX;
+	fixed             PlayerY;
+	fixed             PlayerSpeed;
+	// The columns that the player hasn't fully passed yet, from left to
+	// right, up to CONTROLLER_VIEW_COLUMNS of them.
+	uint32_t          ColumnCount;
+	struct ColumnView Columns[CONTROLLER_VIEW_COLUMNS];
+};
+
+// Fills a controller's view of a game.
+extern void GetControllerView(const struct GameState* State, struct ControllerView* View);
+
+// Boosts the player whenever it's well below the centre of the gap of the
+// next column, and not already rising. Data is unused.
+extern bool AutopilotController(const struct ControllerView* View, void* Data);
+
+#endif /* !defined(_CONTROLLER_H_) */
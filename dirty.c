@@ -0,0 +1,346 @@
+/*
+ * Hocoslamfy, dirty rectangle tracking code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "SDL.h"
+
+#include "main.h"
+#include "init.h"
+#include "dirty.h"
+#include "text.h"
+
+// The number of frames whose changes are remembered: the screen can have up
+// to 3 buffers, and the one being drawn into shows the frame from as many
+// frames ago.
+#define MAX_BUFFER_AGE 3
+
+// A set of rectangles that don't overlap.
+struct DirtyRegion
+{
+	SDL_Rect Rects[MAX_DIRTY_RECTS];
+	// Whether each rectangle holds a text box in full (see UpdateTextSprite).
+	bool     Text[MAX_DIRTY_RECTS];
+	uint32_t Count;
+	// If true, Rects are meaningless, and everything changed.
+	bool     Full;
+};
+
+static uint32_t           DirtyLimit = DEFAULT_DIRTY_LIMIT;
+
+// The changes of the frame being drawn, followed by those of the frames
+// before it, most recent first.
+static struct DirtyRegion Changes[MAX_BUFFER_AGE] = {
+	{ .Full = true }, { .Full = true }, { .Full = true }
+};
+
+// The text boxes printed into in the frame being drawn.
+static SDL_Rect           TextBoxes[MAX_DIRTY_RECTS];
+static uint32_t           TextBoxCount;
+static bool               TooManyTextBoxes;
+
+// What the frame is drawn into, from GetDirtyRects.
+static struct DirtyRegion Drawn;
+
+static const SDL_Rect     FullScreen = { .x = 0, .y = 0, .w = SCREEN_WIDTH, .h = SCREEN_HEIGHT };
+
+void SetDirtyLimit(uint32_t Percent)
+{
+	DirtyLimit = Percent > 100 ? 100 : Percent;
+}
+
+void InvalidateScreen(void)
+{
+	Changes[0].Full = true;
+}
+
+// Returns the part of a rectangle that is on the screen, which may be empty.
+static SDL_Rect ClipToScreen(const SDL_Rect* Rect)
+{
+	int Left = Rect->x < 0 ? 0 : Rect->x,
+	    Top = Rect->y < 0 ? 0 : Rect->y,
+	    Right = Rect->x + Rect->w > SCREEN_WIDTH ? SCREEN_WIDTH : Rect->x + Rect->w,
+	    Bottom = Rect->y + Rect->h > SCREEN_HEIGHT ? SCREEN_HEIGHT : Rect->y + Rect->h;
+	SDL_Rect Result = { .x = 0, .y = 0, .w = 0, .h = 0 };
+	if (Right > Left && Bottom > Top)
+		Result = (SDL_Rect) { .x = Left, .y = Top, .w = Right - Left, .h = Bottom - Top };
+	return Result;
+}
+
+static bool Intersect(const SDL_Rect* A, const SDL_Rect* B)
+{
+	return A->x < B->x + B->w && B->x < A->x + A->w
+	    && A->y < B->y + B->h && B->y < A->y + A->h;
+}
+
+static bool Contains(const SDL_Rect* Outer, const SDL_Rect* Inner)
+{
+	return Inner->x >= Outer->x && Inner->x + Inner->w <= Outer->x + Outer->w
+	    && Inner->y >= Outer->y && Inner->y + Inner->h <= Outer->y + Outer->h;
+}
+
+static SDL_Rect Union(const SDL_Rect* A, const SDL_Rect* B)
+{
+	int Left = A->x < B->x ? A->x : B->x,
+	    Top = A->y < B->y ? A->y : B->y,
+	    Right = A->x + A->w > B->x + B->w ? A->x + A->w : B->x + B->w,
+	    Bottom = A->y + A->h > B->y + B->h ? A->y + A->h : B->y + B->h;
+	return (SDL_Rect) { .x = Left, .y = Top, .w = Right - Left, .h = Bottom - Top };
+}
+
+// Writes the parts of A that aren't in B, which intersects it, into Parts as
+// up to 4 rectangles, and returns how many there are: full-width bands above
+// and below B, then the parts left and right of it.
+static uint32_t Subtract(const SDL_Rect* A, const SDL_Rect* B, SDL_Rect Parts[4])
+{
+	int Top = B->y > A->y ? B->y : A->y,
+	    Bottom = B->y + B->h < A->y + A->h ? B->y + B->h : A->y + A->h;
+	uint32_t Count = 0;
+	if (B->y > A->y)
+		Parts[Count++] = (SDL_Rect) { .x = A->x, .y = A->y, .w = A->w, .h = B->y - A->y };
+	if (B->y + B->h < A->y + A->h)
+		Parts[Count++] = (SDL_Rect) { .x = A->x, .y = Bottom, .w = A->w, .h = A->y + A->h - Bottom };
+	if (B->x > A->x)
+		Parts[Count++] = (SDL_Rect) { .x = A->x, .y = Top, .w = B->x - A->x, .h = Bottom - Top };
+	if (B->x + B->w < A->x + A->w)
+		Parts[Count++] = (SDL_Rect) { .x = B->x + B->w, .y = Top, .w = A->x + A->w - (B->x + B->w), .h = Bottom - Top };
+	return Count;
+}
+
+static void Append(struct DirtyRegion* Region, const SDL_Rect* Rect, bool Text)
+{
+	if (Region->Count == MAX_DIRTY_RECTS)
+		Region->Full = true;
+	else
+	{
+		Region->Text[Region->Count] = Text;
+		Region->Rects[Region->Count++] = *Rect;
+	}
+}
+
+// Adds the parts of a rectangle that aren't in a region yet to it.
+static void AddToRegion(struct DirtyRegion* Region, const SDL_Rect* Rect)
+{
+	SDL_Rect Pending[MAX_DIRTY_RECTS], Parts[4];
+	uint32_t PendingCount = 0, i, j, k;
+
+	Pending[PendingCount++] = ClipToScreen(Rect);
+	if (Region->Full || Pending[0].w == 0)
+		return;
+	// Cut away what each rectangle of the region already covers.
+	for (i = 0; i < Region->Count && PendingCount > 0; i++)
+		for (j = 0; j < PendingCount; )
+		{
+			if (!Intersect(&Pending[j], &Region->Rects[i]))
+			{
+				j++;
+				continue;
+			}
+			uint32_t PartCount = Subtract(&Pending[j], &Region->Rects[i], Parts);
+			if (PendingCount - 1 + PartCount > MAX_DIRTY_RECTS)
+			{
+				Region->Full = true;
+				return;
+			}
+			// The parts don't intersect this rectangle, so skip them.
+			Pending[j] = Pending[--PendingCount];
+			for (k = 0; k < PartCount; k++)
+				Pending[PendingCount++] = Parts[k];
+		}
+	for (i = 0; i < PendingCount; i++)
+		Append(Region, &Pending[i], false);
+}
+
+// Adds a text box to a region in a single rectangle, cutting away what the
+// others have in common with it. Where it overlaps other text boxes, they're
+// all put in their bounding box.
+static void AddTextBoxToRegion(struct DirtyRegion* Region, const SDL_Rect* Box)
+{
+	SDL_Rect New = *Box, Parts[4];
+	uint32_t i, j, PartCount;
+
+	i = 0;
+	while (i < Region->Count)
+	{
+		if (Region->Text[i] && Intersect(&Region->Rects[i], &New))
+		{
+			New = Union(&Region->Rects[i], &New);
+			Region->Rects[i] = Region->Rects[--Region->Count];
+			Region->Text[i] = Region->Text[Region->Count];
+			// The bounding box may overlap text boxes already passed.
+			i = 0;
+		}
+		else
+			i++;
+	}
+	for (i = 0; i < Region->Count && !Region->Full; )
+	{
+		if (!Intersect(&Region->Rects[i], &New))
+		{
+			i++;
+			continue;
+		}
+		PartCount = Subtract(&Region->Rects[i], &New, Parts);
+		Region->Rects[i] = Region->Rects[--Region->Count];
+		Region->Text[i] = Region->Text[Region->Count];
+		for (j = 0; j < PartCount; j++)
+			Append(Region, &Parts[j], false);
+	}
+	Append(Region, &New, true);
+}
+
+void AddDirtyRect(const SDL_Rect* Rect)
+{
+	AddToRegion(&Changes[0], Rect);
+}
+
+static bool SameRect(const SDL_Rect* A, const SDL_Rect* B)
+{
+	return A->x == B->x && A->y == B->y && A->w == B->w && A->h == B->h;
+}
+
+void UpdateSprite(struct ScreenSprite* Sprite, const SDL_Rect* Rect, uint32_t Look)
+{
+	if (Sprite->Shown && SameRect(&Sprite->Rect, Rect) && Sprite->Look == Look)
+		return;
+	if (Sprite->Shown)
+		AddDirtyRect(&Sprite->Rect);
+	AddDirtyRect(Rect);
+	Sprite->Rect = *Rect;
+	Sprite->Look = Look;
+	Sprite->Shown = true;
+}
+
+void HideSprite(struct ScreenSprite* Sprite)
+{
+	if (Sprite->Shown)
+		AddDirtyRect(&Sprite->Rect);
+	Sprite->Shown = false;
+}
+
+void UpdateTextSprite(struct ScreenSprite* Sprite, const SDL_Rect* Rect, uint32_t Look)
+{
+	UpdateSprite(Sprite, Rect, Look);
+	if (TextBoxCount == MAX_DIRTY_RECTS)
+		TooManyTextBoxes = true;
+	else
+		TextBoxes[TextBoxCount++] = ClipToScreen(Rect);
+}
+
+// Returns the number of buffers the screen has, of which the one being drawn
+// into shows the frame from as many frames ago.
+static uint32_t GetBufferAge(void)
+{
+#ifdef SDL_TRIPLEBUF
+	if ((Screen->flags & SDL_TRIPLEBUF) == SDL_TRIPLEBUF)
+		return 3;
+#endif
+	if (Screen->flags & SDL_DOUBLEBUF)
+		return 2;
+	return 1;
+}
+
+void FitTextBox(SDL_Rect* Box, const char* Text)
+{
+	// The outline takes a pixel on each side of the text.
+	uint32_t Width = GetRenderedWidth(Text), Height = GetRenderedHeight(Text);
+	if (Width + 2 > Box->w || Height + 2 > Box->h)
+		return;
+	// Lines are centred with integer division, so the space around them must
+	// stay even or odd for them to stay in place.
+	if ((Box->w - Width) % 2 != 0)
+		Width++;
+	Box->x += (Box->w - 2 - Width) / 2;
+	Box->y += (Box->h - 2 - Height) / 2;
+	Box->w = Width + 2;
+	Box->h = Height + 2;
+}
+
+uint32_t GetDirtyRects(const SDL_Rect** Rects)
+{
+	uint32_t Age = GetBufferAge(), Area = 0, i, j;
+	bool     Added;
+
+	// The buffer being drawn into is missing the changes of the frames it
+	// didn't show.
+	Drawn = Changes[0];
+	for (i = 1; i < Age; i++)
+	{
+		if (Changes[i].Full)
+			Drawn.Full = true;
+		for (j = 0; j < Changes[i].Count; j++)
+			AddToRegion(&Drawn, &Changes[i].Rects[j]);
+	}
+	if (TooManyTextBoxes)
+		Drawn.Full = true;
+	// Text that is printed at all is printed in full, and into a single
+	// rectangle, so that it doesn't go over what is drawn after it in
+	// another one.
+	// Adding one can make another one partly dirty, so repeat until none is.
+	do
+	{
+		Added = false;
+		for (i = 0; i < TextBoxCount && !Drawn.Full; i++)
+			for (j = 0; j < Drawn.Count; j++)
+				if (Intersect(&TextBoxes[i], &Drawn.Rects[j]))
+				{
+					if (!(Drawn.Text[j] && Contains(&Drawn.Rects[j], &TextBoxes[i])))
+					{
+						AddTextBoxToRegion(&Drawn, &TextBoxes[i]);
+						Added = true;
+					}
+					break;
+				}
+	} while (Added && !Drawn.Full);
+
+	for (i = 0; i < Drawn.Count; i++)
+		Area += Drawn.Rects[i].w * Drawn.Rects[i].h;
+	if (Drawn.Full || Area * 100 > DirtyLimit * SCREEN_WIDTH * SCREEN_HEIGHT)
+	{
+		Drawn.Full = true;
+		Drawn.Rects[0] = FullScreen;
+		Drawn.Count = 1;
+	}
+	*Rects = Drawn.Rects;
+	return Drawn.Count;
+}
+
+bool IsTextBoxIn(const SDL_Rect* Box, const SDL_Rect* Rect)
+{
+	SDL_Rect Clipped = ClipToScreen(Box);
+	return Clipped.w != 0 && Contains(Rect, &Clipped);
+}
+
+void PresentFrame(void)
+{
+	// Screens with several buffers show the one that was drawn into in full;
+	// the others can show just what was drawn.
+	if (GetBufferAge() > 1 || Drawn.Full)
+		SDL_Flip(Screen);
+	else if (Drawn.Count > 0)
+		SDL_UpdateRects(Screen, Drawn.Count, Drawn.Rects);
+
+	memmove(&Changes[1], &Changes[0], (MAX_BUFFER_AGE - 1) * sizeof(struct DirtyRegion));
+	Changes[0].Count = 0;
+	Changes[0].Full = false;
+	TextBoxCount = 0;
+	TooManyTextBoxes = false;
+}
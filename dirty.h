@@ -0,0 +1,92 @@
+/*
+ * Hocoslamfy, dirty rectangle tracking header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _DIRTY_H_
+#define _DIRTY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "SDL.h"
+
+// Frames are drawn and presented only where they differ from what the screen
+// shows, unless more than this share of the screen does; then it's drawn and
+// presented in full. (In percent.) 0, drawing every frame in full, is the
+// default until a limit is shown to save anything on the device itself; set
+// one with --dirty-limit.
+#define DEFAULT_DIRTY_LIMIT 0
+
+// The number of rectangles the changes of a frame are kept in. If more are
+// needed, the frame is drawn in full.
+#define MAX_DIRTY_RECTS     64
+
+// Something drawn on the screen, remembered from one frame to the next so
+// that where it was and where it is are both drawn again when it moves or
+// changes. Look is anything that tells how it looks, such as its frame of
+// animation. Sprites start zeroed, not shown.
+struct ScreenSprite
+{
+	SDL_Rect Rect;
+	uint32_t Look;
+	bool     Shown;
+};
+
+// Sets the share of the screen above which frames are drawn in full, in
+// percent. 0 draws all frames in full.
+extern void SetDirtyLimit(uint32_t Percent);
+
+// Makes the next frame be drawn in full, such as after switching screens.
+extern void InvalidateScreen(void);
+
+// Marks a rectangle of the screen as changed in the frame being drawn.
+extern void AddDirtyRect(const SDL_Rect* Rect);
+
+// Tells where a sprite is drawn in the frame being drawn, and how it looks,
+// marking where it was and where it is as changed if either differs from the
+// last frame.
+extern void UpdateSprite(struct ScreenSprite* Sprite, const SDL_Rect* Rect, uint32_t Look);
+
+// Tells that a sprite isn't drawn in the frame being drawn, marking where it
+// was as changed if it was drawn in the last frame.
+extern void HideSprite(struct ScreenSprite* Sprite);
+
+// Same as UpdateSprite, for text printed into the box Rect. Text is printed
+// without clipping (see text.h), so a box is drawn again in full whenever any
+// part of it is; see IsTextBoxIn.
+extern void UpdateTextSprite(struct ScreenSprite* Sprite, const SDL_Rect* Rect, uint32_t Look);
+
+// Shrinks the box Text is printed into, centred in both directions, to the
+// box it actually takes, so that the rest isn't redrawn with it.
+extern void FitTextBox(SDL_Rect* Box, const char* Text);
+
+// After all sprites of a frame are updated, returns the number of rectangles
+// to draw the frame into and sets *Rects to them. They don't overlap. The
+// frame is drawn by setting the clip rectangle of the screen to each one in
+// turn and drawing everything, printing text with IsTextBoxIn.
+extern uint32_t GetDirtyRects(const SDL_Rect** Rects);
+
+// Returns whether the text box of a text sprite is to be printed while
+// drawing into Rect, one of the rectangles given by GetDirtyRects.
+extern bool IsTextBoxIn(const SDL_Rect* Box, const SDL_Rect* Rect);
+
+// Shows the frame that was drawn, then starts tracking the changes of the
+// next one.
+extern void PresentFrame(void);
+
+#endif /* !defined(_DIRTY_H_) */
@@ -0,0 +1,71 @@
+/*
+ * Hocoslamfy, field event queue code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed.h"
+#include "events.h"
+
+uint32_t StepsUntilLeftOf(fixed X, fixed Limit, fixed Scroll)
+{
+	// The first step k at which X + k * Scroll < Limit.
+	int64_t Distance = (int64_t) X - Limit;
+	if (Distance < 0)
+		return 1;
+	return (uint32_t) (Distance / -(int64_t) Scroll + 1);
+}
+
+void ScheduleFieldEvent(struct FieldEventQueue* Queue, uint32_t Time, enum FieldEventType Type, uint32_t Slot)
+{
+	// Columns are generated from left to right, so events are nearly always
+	// added at the end; move the few later ones along otherwise. Times are
+	// compared as differences, so the queue works across the wraparound of
+	// the millisecond counter.
+	uint32_t i = Queue->Count;
+	while (i > 0)
+	{
+		const struct FieldEvent* Previous = GetFieldEvent(Queue, i - 1);
+		if ((int32_t) (Previous->Time - Time) <= 0)
+			break;
+		Queue->Events[(Queue->Start + i) & (FIELD_EVENT_CAPACITY - 1)] = *Previous;
+		i--;
+	}
+	Queue->Events[(Queue->Start + i) & (FIELD_EVENT_CAPACITY - 1)] = (struct FieldEvent) {
+		.Time = Time,
+		.Type = Type,
+		.Slot = Slot
+	};
+	Queue->Count++;
+}
+
+bool PopFieldEvent(struct FieldEventQueue* Queue, uint32_t Time, struct FieldEvent* Event)
+{
+	if (Queue->Count == 0 || (int32_t) (Queue->Events[Queue->Start].Time - Time) > 0)
+		return false;
+	*Event = Queue->Events[Queue->Start];
+	Queue->Start = (Queue->Start + 1) & (FIELD_EVENT_CAPACITY - 1);
+	Queue->Count--;
+	return true;
+}
+
+const struct FieldEvent* GetFieldEvent(const struct FieldEventQueue* Queue, uint32_t Index)
+{
+	return &Queue->Events[(Queue->Start + Index) & (FIELD_EVENT_CAPACITY - 1)];
+}
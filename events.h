@@ -0,0 +1,78 @@
+/*
+ * Hocoslamfy, field event queue header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _EVENTS_H_
+#define _EVENTS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed.h"
+
+// Things that happen to a column at a millisecond that is known as soon as
+// it's generated, since everything on the field scrolls at the same speed
+// and the player doesn't move horizontally. Keeping them in a queue ordered
+// by that millisecond spares looking at every column every millisecond to
+// see whether they happened yet.
+enum FieldEventType
+{
+	FIELD_EVENT_PASS,   /* The column went past the player. */
+	FIELD_EVENT_REMOVE  /* The column went past the left side of the field. */
+};
+
+struct FieldEvent
+{
+	// The number of milliseconds the field will have scrolled for when the
+	// event happens.
+	uint32_t Time;
+	uint16_t Type;
+	// The slot of the column, or of its top rectangle, it happens to.
+	uint16_t Slot;
+};
+
+// The number of events that can be waiting at once: 2 per column, and the
+// field has room for at most 8 columns (see RECTANGLE_CAPACITY). It must be a
+// power of 2.
+#define FIELD_EVENT_CAPACITY 16
+
+// A circular buffer of events, ordered by Time, indexed from Start.
+struct FieldEventQueue
+{
+	struct FieldEvent Events[FIELD_EVENT_CAPACITY];
+	uint32_t          Start;
+	uint32_t          Count;
+};
+
+// Returns the number of milliseconds after which an edge at X, scrolling by
+// Scroll (which is negative) every millisecond, is first strictly left of
+// Limit. That's 1 if it already is.
+extern uint32_t StepsUntilLeftOf(fixed X, fixed Limit, fixed Scroll);
+
+// Adds an event to a queue, after those that happen at the same time or
+// earlier. The queue must have room for it.
+extern void ScheduleFieldEvent(struct FieldEventQueue* Queue, uint32_t Time, enum FieldEventType Type, uint32_t Slot);
+
+// Removes the earliest event from a queue into Event and returns true if it
+// happens at Time or earlier; otherwise, returns false.
+extern bool PopFieldEvent(struct FieldEventQueue* Queue, uint32_t Time, struct FieldEvent* Event);
+
+// Returns the Index-th earliest event in a queue.
+extern const struct FieldEvent* GetFieldEvent(const struct FieldEventQueue* Queue, uint32_t Index);
+
+#endif /* !defined(_EVENTS_H_) */
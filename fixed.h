@@ -0,0 +1,43 @@
+/*
+ * Hocoslamfy, fixed-point arithmetic header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _FIXED_H_
+#define _FIXED_H_
+
+#include <stdint.h>
+
+// The game is simulated with fixed-point numbers, so that it plays out exactly
+// the same way on every platform, regardless of its FPU (or lack thereof) and
+// of the floating-point optimisations made by the compiler.
+// Numbers have 24 fractional bits (Q8.24). This leaves 127 meters of range,
+// and enough precision to express speeds in meters per millisecond.
+typedef int32_t fixed;
+
+#define FIXED_SHIFT 24
+#define FIXED_ONE   (1 << FIXED_SHIFT)
+
+// Converts a constant to fixed-point, rounding to the nearest value.
+// The conversion is done in double precision, so floating-point constants
+// should be converted to double before any arithmetic is done on them.
+#define FIXED(x)          ((fixed) ((double) (x) * FIXED_ONE + ((x) < 0 ? -0.5 : 0.5)))
+
+// Converts a fixed-point number to floating-point, for display only.
+#define FIXED_TO_FLOAT(x) ((float) (x) / FIXED_ONE)
+
+#endif /* !defined(_FIXED_H_) */
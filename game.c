@@ -18,8 +18,10 @@
  */
 
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <time.h>
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 
@@ -30,22 +32,61 @@
 #include "init.h"
 #include "platform.h"
 #include "game.h"
+#include "sim.h"
+#include "replay.h"
+#include "controller.h"
+#include "lookahead.h"
+#include "snapshot.h"
+#include "rewind.h"
+#include "soak.h"
 #include "score.h"
 #include "bg.h"
+#include "dirty.h"
 #include "text.h"
 #include "audio.h"
+#include "title.h"
 
-static uint32_t               Score;
+// The simulation of the game being played. Its rectangle buffer is allocated
+// by the first game, and reused by the following ones.
+static struct GameState       State;
 
 static bool                   Boost;
 static bool                   Pause;
-static enum PlayerStatus      PlayerStatus;
 
-// Where the player is. (Center, meters.)
-static float                  PlayerX;
-static float                  PlayerY;
-// Where the player is going. (Meters per second.)
-static float                  PlayerSpeed;
+// The boosts given in the game being played, saved when the game ends.
+static struct Replay          Recording;
+
+// If Replaying is true, the game being played is a replay of Playback instead,
+// whose next boost is PlaybackBoost. If ReplayUncapped is also true, it's
+// being played as fast as possible without being shown, and the program exits
+// at the end of it.
+static bool                   Replaying;
+static bool                   ReplayUncapped;
+static struct Replay          Playback;
+static uint32_t               PlaybackBoost;
+
+// The controller asked whether to boost before each logic tick, if any.
+static TController            Controller;
+static void*                  ControllerData;
+
+// Whether games are being played for a soak test.
+static bool                   Soaking;
+
+// In practice mode, games can be rewound while the rewind key or button is
+// held (Rewinding), to the snapshots kept in Rewind, and high scores aren't
+// saved.
+static bool                   Practice;
+static bool                   Rewinding;
+static struct RewindBuffer    Rewind;
+
+// If FixedSeed is true, every game is played with GameSeed.
+static bool                   FixedSeed;
+static uint64_t               GameSeed;
+
+// Where the player was before the last logic tick, and how far the columns
+// scrolled during it, so that frames can be drawn between the two ticks.
+static fixed                  PreviousPlayerY;
+static fixed                  PreviousScroll;
 
 // -- Animation control variables --
 
@@ -60,14 +101,71 @@ static bool                   PlayerBlinking;
 // Time the player's character has left before blinking, if Blinking is false.
 static uint32_t               PlayerBlinkTime;
 
-// Passed to the score screen after the player is done dying.
-static enum GameOverReason    GameOverReason;
+// Where the rectangles, by slot, their scores, by the slot of the top one, and
+// the player's character were drawn (see dirty.h).
+static struct ScreenSprite    ColumnSprites[RECTANGLE_CAPACITY];
+static struct ScreenSprite    LabelSprites[RECTANGLE_CAPACITY];
+static struct ScreenSprite    PlayerSprite;
 
-// What the player avoids.
-static struct HocoslamfyRect* Rectangles     = NULL;
-static uint32_t               RectangleCount = 0;
+// What a frame of the game shows, worked out once and then drawn into each
+// part of the screen that changed. Rectangles and their scores are indexed
+// like on the field.
+struct GameFrame
+{
+	SDL_Rect                  ColumnDest[RECTANGLE_CAPACITY];
+	SDL_Rect                  ColumnSource[RECTANGLE_CAPACITY];
+	char                      LabelText[RECTANGLE_CAPACITY / 2][11];
+	Uint32                    LabelColor[RECTANGLE_CAPACITY / 2];
+	SDL_Rect                  LabelRect[RECTANGLE_CAPACITY / 2];
+	bool                      LabelShown[RECTANGLE_CAPACITY / 2];
+	struct SpanSprite*        PlayerImage;
+	SDL_Rect                  PlayerSource;
+	SDL_Rect                  PlayerDest;
+#ifdef DRAW_BEE_COLLISION
+	SDL_Rect                  PlayerPixelsA;
+	SDL_Rect                  PlayerPixelsB;
+#endif
+};
+
+// Whether the game being played is the player's own, rather than a replay or
+// one played by a controller, so that it may be saved and set a high score.
+static bool IsPlayersGame(void)
+{
+	return !Replaying && !Soaking && Controller == NULL;
+}
+
+// Practice games aren't saved: rewinding rewrites their recorded input, so
+// their replays would verify just like those of games played straight.
+static void SaveRecording(void)
+{
+	if (Practice)
+		return;
+	Recording.Score = State.Score;
+	Recording.Duration = State.Time;
+	SaveRunReplay(&Recording);
+}
 
-static float                  GenDistance;
+// Reports whether a replay ended the way it did when it was recorded, then
+// exits if it was played uncapped, or shows its score screen otherwise.
+static void EndReplay(bool* Continue, bool* Error)
+{
+	bool Matches = ReplayMatches(&State, &Playback, PlaybackBoost);
+	printf("Replay of seed %016" PRIx64 ": score %" PRIu32 " after %" PRIu32 " ms, recorded score %" PRIu32 " after %" PRIu32 " ms%s\n",
+		Playback.Seed, State.Score, State.Time, Playback.Score, Playback.Duration,
+		Matches ? "" : " (MISMATCH)");
+	Replaying = false;
+	FinalizeReplay(&Playback);
+
+	if (ReplayUncapped)
+	{
+		*Continue = false;
+		*Error = !Matches;
+	}
+	else if (State.PlayerStatus == DEAD)
+		ToScore(State.Score, State.GameOverReason, GetHighScore());
+	else
+		ToTitleScreen();
+}
 
 void GameGatherInput(bool* Continue)
 {
@@ -75,32 +173,28 @@ void GameGatherInput(bool* Continue)
 
 	while (SDL_PollEvent(&ev))
 	{
-		if (IsBoostEvent(&ev) && !Pause)
+		if (IsBoostEvent(&ev) && !Pause && !Replaying)
 			Boost = true;
-		else if (IsPauseEvent(&ev) && PlayerStatus == ALIVE)
+		else if (IsPauseEvent(&ev) && State.PlayerStatus == ALIVE)
 			Pause = !Pause;
+		else if (IsRewindPressingEvent(&ev) && Practice && !Replaying)
+			Rewinding = true;
+		else if (IsRewindReleasingEvent(&ev))
+			Rewinding = false;
 		else if (IsExitGameEvent(&ev))
 		{
+			// Games that are left before they're over aren't saved: their
+			// replays couldn't verify.
 			*Continue = false;
 			return;
 		}
 	}
 }
 
-static void SetStatus(const enum PlayerStatus NewStatus)
-{
-	PlayerFrameTime = 0;
-	if (NewStatus == COLLIDED && PlayerStatus != COLLIDED)
-		PlaySFXCollision();
-	PlayerStatus = NewStatus;
-	if (NewStatus == DYING)
-		PlayerSpeed = 0.0f;
-}
-
 static void AnimationControl(Uint32 Milliseconds)
 {
 	Uint32 Remainder = Milliseconds;
-	switch (PlayerStatus)
+	switch (State.PlayerStatus)
 	{
 		case ALIVE:
 		case DYING:
@@ -115,9 +209,7 @@ static void AnimationControl(Uint32 Milliseconds)
 			break;
 
 		case COLLIDED:
-			PlayerFrameTime += Remainder;
-			if (PlayerFrameTime > COLLISION_TIME)
-				SetStatus(DYING);
+		case DEAD:
 			break;
 	}
 
@@ -131,7 +223,7 @@ static void AnimationControl(Uint32 Milliseconds)
 			{
 				Remainder -= BLINK_TIME - PlayerBlinkTime;
 				PlayerBlinking = false;
-				PlayerBlinkTime = NONBLINK_TIME_MIN + rand() % (NONBLINK_TIME_MAX - NONBLINK_TIME_MIN);
+				PlayerBlinkTime = NONBLINK_TIME_MIN + RandomBelow(&State.Cosmetic, NONBLINK_TIME_MAX - NONBLINK_TIME_MIN);
 			}
 			else
 			{
@@ -156,160 +248,217 @@ static void AnimationControl(Uint32 Milliseconds)
 	}
 }
 
+// Rewinds the game by Milliseconds * REWIND_SPEED milliseconds, or as far as
+// it can be, by loading the latest snapshot before that time and playing the
+// game again from there with the boosts recorded for its replay.
+static void RewindGame(Uint32 Milliseconds)
+{
+	if (Rewind.Count == 0)
+		return;
+	uint32_t Oldest = GetOldestKeyframeTime(&Rewind);
+	uint32_t Target = State.Time - Oldest > Milliseconds * REWIND_SPEED
+		? State.Time - Milliseconds * REWIND_SPEED
+		: Oldest;
+
+	// LoadRun only lowers the number of recorded boosts, so those after the
+	// snapshot are still there to be played again.
+	uint32_t Recorded = Recording.BoostCount;
+	const struct RunSnapshot* Keyframe = RewindKeyframes(&Rewind, Target);
+	LoadRun(Keyframe);
+	Recording.BoostCount = Recorded;
+
+	uint32_t NextBoost = Keyframe->BoostCount, Replayed = Target - Keyframe->Game.Time;
+	bool WasAlive = State.PlayerStatus == ALIVE;
+	AdvanceReplay(&State, &Recording, &NextBoost, Replayed);
+	if (WasAlive)
+		AdvanceBackground(Replayed);
+	AnimationControl(Replayed);
+
+	// The boosts from the target time onward didn't happen anymore.
+	Recording.BoostCount = NextBoost;
+	PreviousPlayerY = State.PlayerY;
+	PreviousScroll = 0;
+	HoldBackground();
+}
+
 void GameDoLogic(bool* Continue, bool* Error, Uint32 Milliseconds)
 {
-	if (!Pause && PlayerStatus == ALIVE)
+	if (State.Rectangles.Left == NULL)
+	{
+		*Continue = false;  *Error = true;
+		return;
+	}
+
+	if (!Pause && Rewinding)
 	{
-		bool PointAwarded = false;
-		uint32_t Millisecond;
-		for (Millisecond = 0; Millisecond < Milliseconds; Millisecond++)
+		RewindGame(Milliseconds);
+		return;
+	}
+
+	if (!Pause)
+	{
+		enum PlayerStatus OldStatus = State.PlayerStatus;
+		uint32_t Events;
+
+		PreviousPlayerY = State.PlayerY;
+
+		if (Replaying)
+		{
+			// A replay stops at its recorded duration even if the game isn't
+			// over yet, and then doesn't match.
+			if (Milliseconds > Playback.Duration - State.Time)
+				Milliseconds = Playback.Duration - State.Time;
+			Events = AdvanceReplay(&State, &Playback, &PlaybackBoost, Milliseconds);
+		}
+		else
 		{
-			// Scroll all rectangles to the left.
-			int32_t i;
-			for (i = RectangleCount - 1; i >= 0; i--)
+			uint32_t Time = State.Time;
+			if (Practice && NeedsKeyframe(&Rewind, Time))
 			{
-				Rectangles[i].Left += FIELD_SCROLL / 1000;
-				Rectangles[i].Right += FIELD_SCROLL / 1000;
-				// If a rectangle is past the player, award the player with a
-				// point. But there is a pair of them per column!
-				if (!Rectangles[i].Passed
-				 && Rectangles[i].Right < PlayerX)
-				{
-					Rectangles[i].Passed = true;
-					if (!PointAwarded)
-					{
-						Score++;
-						PointAwarded = true;
-						PlaySFXPass();
-					}
-				}
-				// If a rectangle is past the left side, remove it.
-				if (Rectangles[i].Right < 0.0f)
-				{
-					memmove(&Rectangles[i], &Rectangles[i + 1], (RectangleCount - i) * sizeof(struct HocoslamfyRect));
-					RectangleCount--;
-				}
+				struct RunSnapshot Keyframe;
+				SaveRun(&Keyframe);
+				AddKeyframe(&Rewind, &Keyframe);
 			}
-			// Generate a pair of rectangles now if needed.
-			if (RectangleCount == 0 || FIELD_WIDTH - Rectangles[RectangleCount - 1].Right >= GenDistance)
+			if (Controller != NULL && State.PlayerStatus == ALIVE)
 			{
-				float Left;
-				if (RectangleCount == 0)
-					Left = FIELD_WIDTH + FIELD_SCROLL / 1000;
-				else
-				{
-					Left = Rectangles[RectangleCount - 1].Right + GenDistance;
-					GenDistance += RECT_GEN_SPEED;
-					if (GenDistance < RECT_GEN_MIN)
-						GenDistance = RECT_GEN_MIN;
-				}
-				Rectangles = realloc(Rectangles, (RectangleCount + 2) * sizeof(struct HocoslamfyRect));
-				RectangleCount += 2;
-				Rectangles[RectangleCount - 2].Passed = Rectangles[RectangleCount - 1].Passed = false;
-				Rectangles[RectangleCount - 2].Left = Rectangles[RectangleCount - 1].Left = Left;
-				Rectangles[RectangleCount - 2].Right = Rectangles[RectangleCount - 1].Right = Left + RECT_WIDTH;
-				// Where's the place for the player to go through?
-				float GapTop = GAP_HEIGHT + (FIELD_HEIGHT / 16.0f) + ((float) rand() / (float) RAND_MAX) * (FIELD_HEIGHT - GAP_HEIGHT - (FIELD_HEIGHT / 8.0f));
-				Rectangles[RectangleCount - 2].Top = FIELD_HEIGHT;
-				Rectangles[RectangleCount - 2].Bottom = GapTop;
-				Rectangles[RectangleCount - 1].Top = GapTop - GAP_HEIGHT;
-				Rectangles[RectangleCount - 1].Bottom = 0.0f;
-				Rectangles[RectangleCount - 2].Frame = rand() % 3;
-				Rectangles[RectangleCount - 1].Frame = rand() % 3;
+				struct ControllerView View;
+				GetControllerView(&State, &View);
+				if (Controller(&View, ControllerData))
+					Boost = true;
 			}
-			// Update the speed at which the player is going.
-			PlayerSpeed += GRAVITY / 1000;
-			if (Boost)
-			{
-				// The player expects to rise a constant amount with each press of
-				// the triggering key or button, so set his or her speed to
-				// boost him or her from zero, even if the speed was positive.
-				// For a more physically-realistic version of thrust, use
-				// [PlayerSpeed += SPEED_BOOST;].
-				PlayerSpeed = SPEED_BOOST;
-				Boost = false;
+			Events = AdvanceGameState(&State, Boost, Milliseconds);
+			if ((Events & GAME_EVENT_BOOST) && !RecordBoost(&Recording, Time))
+				printf("Failed to record a boost for the replay\n");
+		}
+
+		if (Events & GAME_EVENT_BOOST)
+			Boost = false;
+		if (!ReplayUncapped)
+		{
+			if (Events & GAME_EVENT_BOOST)
 				PlaySFXFly();
-			}
-			// Update the player's position.
-			// If the player's position has collided with the borders of the field,
-			// the player's game is over.
-			PlayerY += PlayerSpeed / 1000;
-			if (PlayerY + (COLLISION_B_HEIGHT / 2) > FIELD_HEIGHT || PlayerY - (COLLISION_B_HEIGHT / 2) < 0.0f)
-			{
-				SetStatus(COLLIDED);
-				GameOverReason = FIELD_BORDER_COLLISION;
-				break;
-			}
-			// Collision detection.
-			for (i = 0; i < RectangleCount; i++)
-			{
-				if ((((PlayerY + (COLLISION_A_HEIGHT / 2) > Rectangles[i].Bottom
-				    && PlayerY + (COLLISION_A_HEIGHT / 2) < Rectangles[i].Top)
-				   || (PlayerY - (COLLISION_A_HEIGHT / 2) > Rectangles[i].Bottom
-				    && PlayerY - (COLLISION_A_HEIGHT / 2) < Rectangles[i].Top))
-				  && ((PlayerX - (COLLISION_A_WIDTH  / 2) > Rectangles[i].Left
-				    && PlayerX - (COLLISION_A_WIDTH  / 2) < Rectangles[i].Right)
-				   || (PlayerX + (COLLISION_A_WIDTH  / 2) > Rectangles[i].Left
-				    && PlayerX + (COLLISION_A_WIDTH  / 2) < Rectangles[i].Right)))
-				 || (((PlayerY + (COLLISION_B_HEIGHT / 2) > Rectangles[i].Bottom
-				    && PlayerY + (COLLISION_B_HEIGHT / 2) < Rectangles[i].Top)
-				   || (PlayerY - (COLLISION_B_HEIGHT / 2) > Rectangles[i].Bottom
-				    && PlayerY - (COLLISION_B_HEIGHT / 2) < Rectangles[i].Top))
-				  && ((PlayerX - (COLLISION_B_WIDTH  / 2) > Rectangles[i].Left
-				    && PlayerX - (COLLISION_B_WIDTH  / 2) < Rectangles[i].Right)
-				   || (PlayerX + (COLLISION_B_WIDTH  / 2) > Rectangles[i].Left
-				    && PlayerX + (COLLISION_B_WIDTH  / 2) < Rectangles[i].Right))))
-				{
-					SetStatus(COLLIDED);
-					GameOverReason = RECTANGLE_COLLISION;
-					break;
-				}
-			}
+			if (Events & GAME_EVENT_PASS)
+				PlaySFXPass();
+			if (Events & GAME_EVENT_COLLIDE)
+				PlaySFXCollision();
 		}
 
-		AdvanceBackground(Milliseconds);
-	}
-	else if (PlayerStatus == DYING)
-	{
-		uint32_t Millisecond;
-		for (Millisecond = 0; Millisecond < Milliseconds; Millisecond++)
+		// The columns stop scrolling when the player collides with something.
+		PreviousScroll = 0;
+		if (OldStatus == ALIVE)
 		{
-			// Update the speed at which the player is going.
-			PlayerSpeed += GRAVITY / 1000;
-			// Update the player's position.
-			// If the player's position has reached the bottom of the screen,
-			// send him or her to the score screen.
-			PlayerY += PlayerSpeed / 1000;
-			if (PlayerY < 0.0f)
-			{
-				uint32_t HighScore = GetHighScore();
-				
-				ToScore(Score, GameOverReason, HighScore);
-				
-				if (Score > HighScore)
-					SaveHighScore(Score);
-				return;
-			}
+			uint32_t AliveTime = State.PlayerStatus == ALIVE ? Milliseconds : Milliseconds - State.CollisionTime;
+			PreviousScroll = (fixed) AliveTime * State.Parameters.FieldScroll;
+			AdvanceBackground(Milliseconds);
+		}
+		else
+			HoldBackground();
+		if (State.PlayerStatus != OldStatus)
+			PlayerFrameTime = 0;
+
+		// Once the player has reached the bottom of the screen, send him or
+		// her to the score screen.
+		if (Replaying && ((Events & GAME_EVENT_DIE) || State.Time >= Playback.Duration))
+		{
+			EndReplay(Continue, Error);
+			return;
+		}
+		if ((Events & GAME_EVENT_DIE) && Soaking)
+		{
+			SoakGameOver(State.Score);
+			ToGame();
+			return;
+		}
+		if (Events & GAME_EVENT_DIE)
+		{
+			if (IsPlayersGame())
+				SaveRecording();
+
+			uint32_t HighScore = GetHighScore();
+			
+			ToScore(State.Score, State.GameOverReason, HighScore);
+			
+			if (State.Score > HighScore && !Practice && IsPlayersGame())
+				SaveHighScore(State.Score);
+			return;
 		}
 	}
+	else
+	{
+		PreviousPlayerY = State.PlayerY;
+		PreviousScroll = 0;
+		HoldBackground();
+	}
 
 	AnimationControl(Milliseconds);
 }
 
-void GameOutputFrame()
+static void DrawGame(const struct GameFrame* Frame, const SDL_Rect* Clip)
 {
+	uint32_t i;
+
 	// Draw the background.
 	DrawBackground();
 
 	// Draw the rectangles.
+	for (i = 0; i < State.RectangleCount; i++)
+		BlitSpanSprite(ColumnSprite, &Frame->ColumnSource[i], Screen, &Frame->ColumnDest[i]);
+
+	// Draw the scores corresponding to each rectangle.
+	if (SDL_MUSTLOCK(Screen))
+		SDL_LockSurface(Screen);
+	for (i = 0; i < State.RectangleCount; i += 2)
+	{
+		if (Frame->LabelShown[i / 2] && IsTextBoxIn(&Frame->LabelRect[i / 2], Clip))
+			PrintStringOutline32(Frame->LabelText[i / 2],
+				Frame->LabelColor[i / 2],
+				SDL_MapRGB(Screen->format, 0, 0, 0),
+				Screen->pixels,
+				Screen->pitch,
+				Frame->LabelRect[i / 2].x,
+				Frame->LabelRect[i / 2].y,
+				Frame->LabelRect[i / 2].w,
+				Frame->LabelRect[i / 2].h,
+				CENTER,
+				MIDDLE);
+	}
+	if (SDL_MUSTLOCK(Screen))
+		SDL_UnlockSurface(Screen);
+
+	// Draw the character.
+	BlitSpanSprite(Frame->PlayerImage, &Frame->PlayerSource, Screen, &Frame->PlayerDest);
+#ifdef DRAW_BEE_COLLISION
+	if (State.PlayerStatus == ALIVE)
+	{
+		SDL_Rect Dest = Frame->PlayerPixelsA;
+		SDL_FillRect(Screen, &Dest, SDL_MapRGB(Screen->format, 255, 255, 255));
+		Dest = Frame->PlayerPixelsB;
+		SDL_FillRect(Screen, &Dest, SDL_MapRGB(Screen->format, 255, 255, 255));
+	}
+#endif
+}
+
+void GameOutputFrame()
+{
+	// Things are drawn where they were FrameInterpolation of the way between
+	// the previous logic tick and the last one.
+	float Behind = 1.0f - FrameInterpolation;
+	float ColumnOffset = -Behind * FIXED_TO_FLOAT(PreviousScroll);
+	struct GameFrame Frame;
+	bool SlotShown[RECTANGLE_CAPACITY] = { false };
+
+	UpdateBackgroundSprites();
+
+	// Place the rectangles.
 	uint32_t i;
-	for (i = 0; i < RectangleCount; i++)
+	for (i = 0; i < State.RectangleCount; i++)
 	{
+		uint32_t Slot = RectangleSlot(&State, i);
 		SDL_Rect ColumnDestRect = {
-			.x = (int) (Rectangles[i].Left * SCREEN_WIDTH / FIELD_WIDTH) - 20,
-			.y = SCREEN_HEIGHT - (int) (Rectangles[i].Top * SCREEN_HEIGHT / FIELD_HEIGHT),
-			.w = (int) ((Rectangles[i].Right - Rectangles[i].Left) * SCREEN_WIDTH / FIELD_WIDTH) + 40,
-			.h = (int) ((Rectangles[i].Top - Rectangles[i].Bottom) * SCREEN_HEIGHT / FIELD_HEIGHT)
+			.x = (int) ((FIXED_TO_FLOAT(State.Rectangles.Left[Slot]) + ColumnOffset) * SCREEN_WIDTH / FIELD_WIDTH) - 20,
+			.y = SCREEN_HEIGHT - (int) (FIXED_TO_FLOAT(State.Rectangles.Top[Slot]) * SCREEN_HEIGHT / FIELD_HEIGHT),
+			.w = (int) (FIXED_TO_FLOAT(State.Rectangles.Right[Slot] - State.Rectangles.Left[Slot]) * SCREEN_WIDTH / FIELD_WIDTH) + 40,
+			.h = (int) (FIXED_TO_FLOAT(State.Rectangles.Top[Slot] - State.Rectangles.Bottom[Slot]) * SCREEN_HEIGHT / FIELD_HEIGHT)
 		};
 		SDL_Rect ColumnSourceRect = { .x = 0, .y = 0, .w = ColumnDestRect.w, .h = ColumnDestRect.h };
 		// Odd-numbered rectangle indices are at the bottom of the field,
@@ -319,60 +468,67 @@ void GameOutputFrame()
 		} else {
 			ColumnSourceRect.y = 480 - ColumnDestRect.h;
 		}
-		ColumnSourceRect.x = 64 * Rectangles[i].Frame;
-		SDL_BlitSurface(ColumnImage, &ColumnSourceRect, Screen, &ColumnDestRect);
+		ColumnSourceRect.x = 64 * State.Rectangles.Frame[Slot];
+		Frame.ColumnDest[i] = ColumnDestRect;
+		Frame.ColumnSource[i] = ColumnSourceRect;
+		UpdateSprite(&ColumnSprites[Slot], &ColumnDestRect, ((uint32_t) ColumnSourceRect.x << 16) | ColumnSourceRect.y);
+		SlotShown[Slot] = true;
 	}
 
 	uint32_t PassedCount = 0;
-	for (i = 0; i < RectangleCount; i += 2)
+	for (i = 0; i < State.RectangleCount; i += 2)
 	{
-		if (Rectangles[i].Passed)
+		if (State.Rectangles.Passed[RectangleSlot(&State, i)])
 			PassedCount++;
 	}
 
-	// Draw the scores corresponding to each rectangle.
+	// Place the scores corresponding to each rectangle.
 	// Above, we grabbed the number of passed rectangles, so now we can get
 	// the score represented by the first rectangle shown.
-	uint32_t RectScore = Score - PassedCount;
-	if (SDL_MUSTLOCK(Screen))
-		SDL_LockSurface(Screen);
-	for (i = 0; i < RectangleCount; i += 2)
+	uint32_t RectScore = State.Score - PassedCount;
+	for (i = 0; i < State.RectangleCount; i += 2)
 	{
+		uint32_t Slot = RectangleSlot(&State, i);
 		RectScore++;
-		char RectScoreString[11];
+		char* RectScoreString = Frame.LabelText[i / 2];
 		sprintf(RectScoreString, "%" PRIu32, RectScore);
 		uint32_t RenderedWidth = GetRenderedWidth(RectScoreString) + 2;
-		int32_t Left = (int32_t) (((Rectangles[i].Left + Rectangles[i].Right) / 2) * SCREEN_WIDTH / FIELD_WIDTH) - RenderedWidth / 2;
+		int32_t Left = (int32_t) ((FIXED_TO_FLOAT(State.Rectangles.Left[Slot] + State.Rectangles.Right[Slot]) / 2 + ColumnOffset) * SCREEN_WIDTH / FIELD_WIDTH) - RenderedWidth / 2;
 
-		if (Left >= 0 && Left + RenderedWidth < SCREEN_WIDTH)
+		Frame.LabelShown[i / 2] = Left >= 0 && Left + RenderedWidth < SCREEN_WIDTH;
+		if (!Frame.LabelShown[i / 2])
 		{
-			Uint32 RectScoreColor;
-			if (Rectangles[i].Passed)
-				RectScoreColor = SDL_MapRGB(Screen->format, 64, 255, 64); // green
-			else
-				RectScoreColor = SDL_MapRGB(Screen->format, 255, 255, 255); // white
-			PrintStringOutline32(RectScoreString,
-				RectScoreColor,
-				SDL_MapRGB(Screen->format, 0, 0, 0),
-				Screen->pixels,
-				Screen->pitch,
-				Left,
-				/* Even-numbered rectangle indices are at the top of the field,
-				 * so start the Y below that. */
-				SCREEN_HEIGHT - (int) (Rectangles[i].Bottom * SCREEN_HEIGHT / FIELD_HEIGHT),
-				RenderedWidth,
-				(int) (GAP_HEIGHT * SCREEN_HEIGHT / FIELD_HEIGHT),
-				CENTER,
-				MIDDLE);
+			HideSprite(&LabelSprites[Slot]);
+			continue;
 		}
+		if (State.Rectangles.Passed[Slot])
+			Frame.LabelColor[i / 2] = SDL_MapRGB(Screen->format, 64, 255, 64); // green
+		else
+			Frame.LabelColor[i / 2] = SDL_MapRGB(Screen->format, 255, 255, 255); // white
+		Frame.LabelRect[i / 2] = (SDL_Rect) {
+			.x = Left,
+			/* Even-numbered rectangle indices are at the top of the field,
+			 * so start the Y below that. */
+			.y = SCREEN_HEIGHT - (int) (FIXED_TO_FLOAT(State.Rectangles.Bottom[Slot]) * SCREEN_HEIGHT / FIELD_HEIGHT),
+			.w = RenderedWidth,
+			.h = (int) (FIXED_TO_FLOAT(State.Parameters.GapHeight) * SCREEN_HEIGHT / FIELD_HEIGHT)
+		};
+		UpdateTextSprite(&LabelSprites[Slot], &Frame.LabelRect[i / 2], RectScore * 2 + State.Rectangles.Passed[Slot]);
 	}
-	if (SDL_MUSTLOCK(Screen))
-		SDL_UnlockSurface(Screen);
 
-	// Draw the character.
+	for (i = 0; i < RECTANGLE_CAPACITY; i++)
+		if (!SlotShown[i])
+		{
+			HideSprite(&ColumnSprites[i]);
+			HideSprite(&LabelSprites[i]);
+		}
+
+	// Place the character.
+	float PlayerXMeters = FIXED_TO_FLOAT(State.PlayerX),
+	      PlayerYMeters = FIXED_TO_FLOAT(State.PlayerY) - Behind * FIXED_TO_FLOAT(State.PlayerY - PreviousPlayerY);
 	SDL_Rect PlayerDestRect = {
-		.x = (int) (PlayerX * SCREEN_WIDTH / FIELD_WIDTH) - (PLAYER_FRAME_SIZE / 2),
-		.y = (int) (SCREEN_HEIGHT - (PlayerY * SCREEN_HEIGHT / FIELD_HEIGHT)) - (PLAYER_FRAME_SIZE / 2),
+		.x = (int) (PlayerXMeters * SCREEN_WIDTH / FIELD_WIDTH) - (PLAYER_FRAME_SIZE / 2),
+		.y = (int) (SCREEN_HEIGHT - (PlayerYMeters * SCREEN_HEIGHT / FIELD_HEIGHT)) - (PLAYER_FRAME_SIZE / 2),
 		.w = (int) PLAYER_FRAME_SIZE,
 		.h = (int) PLAYER_FRAME_SIZE
 	};
@@ -383,34 +539,30 @@ void GameOutputFrame()
 		.h = 32
 	};
 #ifdef DRAW_BEE_COLLISION
-	SDL_Rect PlayerPixelsA = {
-		.x = (int) ((PlayerX - (COLLISION_A_WIDTH / 2)) * SCREEN_WIDTH / FIELD_WIDTH),
-		.y = (int) (SCREEN_HEIGHT - ((PlayerY + (COLLISION_A_HEIGHT / 2)) * SCREEN_HEIGHT / FIELD_HEIGHT)),
+	Frame.PlayerPixelsA = (SDL_Rect) {
+		.x = (int) ((PlayerXMeters - (COLLISION_A_WIDTH / 2)) * SCREEN_WIDTH / FIELD_WIDTH),
+		.y = (int) (SCREEN_HEIGHT - ((PlayerYMeters + (COLLISION_A_HEIGHT / 2)) * SCREEN_HEIGHT / FIELD_HEIGHT)),
 		.w = (int) (COLLISION_A_WIDTH * SCREEN_HEIGHT / FIELD_HEIGHT),
 		.h = (int) (COLLISION_A_HEIGHT * SCREEN_HEIGHT / FIELD_HEIGHT)
 	};
-	SDL_Rect PlayerPixelsB = {
-		.x = (int) ((PlayerX - (COLLISION_B_WIDTH / 2)) * SCREEN_WIDTH / FIELD_WIDTH),
-		.y = (int) (SCREEN_HEIGHT - ((PlayerY + (COLLISION_B_HEIGHT / 2)) * SCREEN_HEIGHT / FIELD_HEIGHT)),
+	Frame.PlayerPixelsB = (SDL_Rect) {
+		.x = (int) ((PlayerXMeters - (COLLISION_B_WIDTH / 2)) * SCREEN_WIDTH / FIELD_WIDTH),
+		.y = (int) (SCREEN_HEIGHT - ((PlayerYMeters + (COLLISION_B_HEIGHT / 2)) * SCREEN_HEIGHT / FIELD_HEIGHT)),
 		.w = (int) (COLLISION_B_WIDTH * SCREEN_HEIGHT / FIELD_HEIGHT),
 		.h = (int) (COLLISION_B_HEIGHT * SCREEN_HEIGHT / FIELD_HEIGHT)
 	};
 #endif
-	switch (PlayerStatus)
+	switch (State.PlayerStatus)
 	{
 		case ALIVE:
-			if (PlayerSpeed > -2.0f) {
+			if (State.PlayerSpeed > FIXED(-2.0 / 1000)) {
 				PlayerSourceRect.x = 32 * PlayerFrame;
 			} else {
 				PlayerSourceRect.x = 128 + 32 * PlayerFrame;
 			}
 			if (PlayerBlinking)
 				PlayerSourceRect.x += 64;
-			SDL_BlitSurface(CharacterFrames, &PlayerSourceRect, Screen, &PlayerDestRect);
-#ifdef DRAW_BEE_COLLISION
-			SDL_FillRect(Screen, &PlayerPixelsA, SDL_MapRGB(Screen->format, 255, 255, 255));
-			SDL_FillRect(Screen, &PlayerPixelsB, SDL_MapRGB(Screen->format, 255, 255, 255));
-#endif
+			Frame.PlayerImage = CharacterSprite;
 			break;
 
 		case COLLIDED:
@@ -420,42 +572,141 @@ void GameOutputFrame()
 			PlayerDestRect.y -= 8;
 			PlayerDestRect.w += 16;
 			PlayerDestRect.h += 16;
-			SDL_BlitSurface(CollisionImage, &PlayerSourceRect, Screen, &PlayerDestRect);
+			Frame.PlayerImage = CollisionSprite;
 			break;
 
 		case DYING:
+		case DEAD:
+		default:
 			PlayerSourceRect.x = 256 + 32 * PlayerFrame;
-			SDL_BlitSurface(CharacterFrames, &PlayerSourceRect, Screen, &PlayerDestRect);
+			Frame.PlayerImage = CharacterSprite;
 			break;
 	}
-
-	SDL_Flip(Screen);
+	Frame.PlayerSource = PlayerSourceRect;
+	Frame.PlayerDest = PlayerDestRect;
+	UpdateSprite(&PlayerSprite, &PlayerDestRect, ((uint32_t) State.PlayerStatus << 16) | PlayerSourceRect.x);
+
+	// Draw everything into the parts of the screen that changed.
+	const SDL_Rect* Rects;
+	uint32_t Count = GetDirtyRects(&Rects);
+	for (i = 0; i < Count; i++)
+	{
+		SDL_SetClipRect(Screen, &Rects[i]);
+		DrawGame(&Frame, &Rects[i]);
+	}
+	SDL_SetClipRect(Screen, NULL);
+	PresentFrame();
 }
 
-void ToGame(void)
+// Starts a game with the given seed.
+static void StartGame(uint64_t Seed)
 {
-	Score = 0;
 	Boost = false;
 	Pause = false;
-	SetStatus(ALIVE);
-	PlayerX = FIELD_WIDTH / 4;
-	PlayerY = FIELD_HEIGHT / 2;
-	PlayerSpeed = 0.0f;
 
 	PlayerFrame = 0;
 	PlayerFrameTime = 0;
 	PlayerBlinking = true;
 	PlayerBlinkTime = 0;
 
-	if (Rectangles != NULL)
-	{
-		free(Rectangles);
-		Rectangles = NULL;
-	}
-	RectangleCount = 0;
-	GenDistance = RECT_GEN_START;
-
+	if (State.Rectangles.Left != NULL)
+		ResetGameState(&State, Seed);
+	else if (!InitializeGameState(&State, Seed))
+		printf("Failed to allocate the rectangles of the game\n");
+	State.GapQueue = StartGapLookahead(Seed, &State.Parameters);
+	PreviousPlayerY = State.PlayerY;
+	PreviousScroll = 0;
+	Rewinding = false;
+	ClearRewindBuffer(&Rewind);
+
+	InvalidateScreen();
 	GatherInput = GameGatherInput;
 	DoLogic     = GameDoLogic;
 	OutputFrame = GameOutputFrame;
 }
+
+void ToGame(void)
+{
+	// Each game is different, unless a seed was given.
+	uint64_t Seed = FixedSeed ? GameSeed : ((uint64_t) time(NULL) << 32) | SDL_GetTicks();
+
+	StartGame(Seed);
+	Replaying = false;
+	ReplayUncapped = false;
+	FinalizeReplay(&Recording);
+	InitializeReplay(&Recording, Seed);
+}
+
+void SaveRun(struct RunSnapshot* Snapshot)
+{
+	SaveGameState(&State, &Snapshot->Game);
+	SaveBackground(Snapshot->BackgroundX);
+	Snapshot->PlayerFrame = PlayerFrame;
+	Snapshot->PlayerBlinking = PlayerBlinking;
+	Snapshot->PlayerFrameTime = PlayerFrameTime;
+	Snapshot->PlayerBlinkTime = PlayerBlinkTime;
+	Snapshot->PreviousPlayerY = PreviousPlayerY;
+	Snapshot->PreviousScroll = PreviousScroll;
+	Snapshot->BoostCount = Replaying ? PlaybackBoost : Recording.BoostCount;
+}
+
+void LoadRun(const struct RunSnapshot* Snapshot)
+{
+	// The game generates its own gaps from then on, so nothing would take
+	// those of the queue anymore.
+	LoadGameState(&State, &Snapshot->Game);
+	StopGapLookahead();
+	LoadBackground(Snapshot->BackgroundX);
+	PlayerFrame = Snapshot->PlayerFrame;
+	PlayerBlinking = Snapshot->PlayerBlinking;
+	PlayerFrameTime = Snapshot->PlayerFrameTime;
+	PlayerBlinkTime = Snapshot->PlayerBlinkTime;
+	PreviousPlayerY = Snapshot->PreviousPlayerY;
+	PreviousScroll = Snapshot->PreviousScroll;
+	if (Replaying)
+		PlaybackBoost = Snapshot->BoostCount;
+	else if (Snapshot->BoostCount < Recording.BoostCount)
+		Recording.BoostCount = Snapshot->BoostCount;
+	Boost = false;
+}
+
+void SetGameController(TController NewController, void* Data)
+{
+	Controller = NewController;
+	ControllerData = Data;
+}
+
+void SetPracticeMode(bool Enabled)
+{
+	Practice = Enabled;
+}
+
+bool IsPracticeMode(void)
+{
+	return Practice;
+}
+
+void SetGameSeed(uint64_t Seed)
+{
+	FixedSeed = true;
+	GameSeed = Seed;
+}
+
+void ToSoakTest(void)
+{
+	Soaking = true;
+	SetGameController(AutopilotController, NULL);
+	ToGame();
+}
+
+bool ToReplay(const char* Path, bool Uncapped)
+{
+	if (!LoadReplay(&Playback, Path))
+		return false;
+
+	StartGame(Playback.Seed);
+	Replaying = true;
+	ReplayUncapped = Uncapped;
+	PlaybackBoost = 0;
+	return true;
+}
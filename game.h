@@ -20,6 +20,11 @@
 #ifndef _GAME_H_
 #define _GAME_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed.h"
+
 // All speed and acceleration modifiers follow the same directions.
 // Vertically: Positive values go upward, and negative values go downward.
 // Horizontally: Positive values go rightward, and negative values go leftward.
@@ -102,23 +107,64 @@
 
 #define FIELD_WIDTH    (SCREEN_WIDTH * (FIELD_HEIGHT / SCREEN_HEIGHT))
 
-struct HocoslamfyRect
-{
-	float Left;
-	float Top;
-	float Right;
-	float Bottom;
-	bool  Passed;
-	int   Frame;
-};
-
-enum PlayerStatus
-{
-	ALIVE,
-	COLLIDED,
-	DYING
-};
+// The above, in the fixed-point units of the simulation (see fixed.h).
+// Distances are in meters, speeds in meters per millisecond and accelerations
+// in meters per millisecond per millisecond, so that stepping the game by one
+// millisecond only needs additions.
+// The simulation takes SPEED_BOOST, GRAVITY, FIELD_SCROLL, RECT_GEN_START,
+// RECT_GEN_SPEED, RECT_GEN_MIN and GAP_HEIGHT from a GameParameters block
+// (see params.h), of which these are the defaults.
+#define FIXED_SPEED_BOOST        FIXED((double) SPEED_BOOST / 1000)
+#define FIXED_GRAVITY            FIXED((double) GRAVITY / 1000000)
+#define FIXED_FIELD_SCROLL       FIXED((double) FIELD_SCROLL / 1000)
+#define FIXED_RECT_GEN_START     FIXED((double) RECT_GEN_START)
+#define FIXED_RECT_GEN_SPEED     FIXED((double) RECT_GEN_SPEED)
+#define FIXED_RECT_GEN_MIN       FIXED((double) RECT_GEN_MIN)
+#define FIXED_RECT_WIDTH         FIXED((double) RECT_WIDTH)
+#define FIXED_GAP_HEIGHT         FIXED((double) GAP_HEIGHT)
+#define FIXED_COLLISION_A_WIDTH  FIXED((double) COLLISION_A_WIDTH)
+#define FIXED_COLLISION_A_HEIGHT FIXED((double) COLLISION_A_HEIGHT)
+#define FIXED_COLLISION_B_WIDTH  FIXED((double) COLLISION_B_WIDTH)
+#define FIXED_COLLISION_B_HEIGHT FIXED((double) COLLISION_B_HEIGHT)
+#define FIXED_FIELD_HEIGHT       FIXED((double) FIELD_HEIGHT)
+#define FIXED_FIELD_WIDTH        FIXED((double) SCREEN_WIDTH * FIELD_HEIGHT / SCREEN_HEIGHT)
+
+// Where the player starts. The player never moves horizontally.
+#define FIXED_PLAYER_X           (FIXED_FIELD_WIDTH / 4)
+#define FIXED_PLAYER_START_Y     (FIXED_FIELD_HEIGHT / 2)
+
+struct ControllerView;
+
+// Decides whether the player boosts at the start of the next logic tick,
+// given a view of the game (see controller.h). Data is whatever was given
+// along with the controller.
+typedef bool (*TController) (const struct ControllerView* View, void* Data);
 
 extern void ToGame(void);
 
+// Makes the player boost whenever Controller says so, in addition to when
+// the player presses the boost key or button, in the games that follow.
+// NULL stops that.
+extern void SetGameController(TController Controller, void* Data);
+
+// In practice mode, the game can be rewound up to REWIND_TIME milliseconds
+// (see rewind.h) by holding the rewind key or button, and neither high scores
+// nor replays are saved.
+extern void SetPracticeMode(bool Enabled);
+extern bool IsPracticeMode(void);
+
+// Plays every game that follows with the given seed, like a daily challenge,
+// rather than with a new seed each time.
+extern void SetGameSeed(uint64_t Seed);
+
+// Plays games with the autopilot one after the other, without saving their
+// replays or scores, for a soak test (see soak.h).
+extern void ToSoakTest(void);
+
+// Plays back the replay in the file at Path instead of a game. If Uncapped is
+// true, the replay is played as fast as possible and the program exits after
+// reporting whether it matches its recording; main must then not draw frames.
+// Returns false if the replay could not be loaded.
+extern bool ToReplay(const char* Path, bool Uncapped);
+
 #endif /* !defined(_GAME_H_) */
@@ -0,0 +1,166 @@
+/*
+ * Hocoslamfy, column gap generator code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed.h"
+#include "rng.h"
+#include "init.h"
+#include "game.h"
+#include "collision.h"
+#include "gaps.h"
+
+// Gap tops are drawn from GapTopMin up to, but excluding, GapTopMax, leaving
+// a 16th of the field above and below every gap.
+static fixed GapTopMin(const struct GapGenerator* Generator)
+{
+	return Generator->Parameters.GapHeight + FIXED_FIELD_HEIGHT / 16;
+}
+
+static fixed GapTopMax(const struct GapGenerator* Generator)
+{
+	return FIXED_FIELD_HEIGHT - FIXED_FIELD_HEIGHT / 16;
+}
+
+// How far the player's center stays from the edges of a gap, and of the
+// field, to not collide with them. This is the larger of the half-heights of
+// the collision rectangles, so it's a little pessimistic for rectangle A.
+#define GAP_MARGIN  COLLISION_B_HALF_HEIGHT
+
+// The number of milliseconds it takes a column to scroll by Distance.
+static uint32_t ScrollTime(const struct GapGenerator* Generator, fixed Distance)
+{
+	return Distance > 0 ? (uint32_t) (Distance / -Generator->Parameters.FieldScroll) : 0;
+}
+
+// Widens the range of heights the player's center can be at by those it can
+// reach within Milliseconds: rising by boosting every millisecond, or falling
+// from rest, as it can be when it hovers by boosting every so often.
+static void ExpandReach(struct GapGenerator* Generator, uint32_t Milliseconds)
+{
+	int64_t T = Milliseconds;
+	int64_t Rise = T * (Generator->Parameters.SpeedBoost + Generator->Parameters.Gravity);
+	int64_t Fall = -(T * (T - 1) / 2 * Generator->Parameters.Gravity);
+	int64_t Bottom = (int64_t) Generator->ReachBottom - Fall;
+	int64_t Top = (int64_t) Generator->ReachTop + Rise;
+	Generator->ReachBottom = Bottom > GAP_MARGIN ? (fixed) Bottom : GAP_MARGIN;
+	Generator->ReachTop = Top < FIXED_FIELD_HEIGHT - GAP_MARGIN ? (fixed) Top : FIXED_FIELD_HEIGHT - GAP_MARGIN;
+}
+
+// Narrows the range of heights the player's center can be at to those within
+// a gap. Returns false if none are.
+static bool ClipReach(struct GapGenerator* Generator, fixed GapTop)
+{
+	fixed Bottom = GapTop - Generator->Parameters.GapHeight + GAP_MARGIN, Top = GapTop - GAP_MARGIN;
+	if (Generator->ReachBottom > Top || Generator->ReachTop < Bottom)
+		return false;
+	if (Generator->ReachBottom < Bottom)
+		Generator->ReachBottom = Bottom;
+	if (Generator->ReachTop > Top)
+		Generator->ReachTop = Top;
+	return true;
+}
+
+void InitializeGapGenerator(struct GapGenerator* Generator, uint64_t Seed, const struct GameParameters* Parameters)
+{
+	Generator->Parameters = *Parameters;
+	SeedRandom(&Generator->Gameplay, Seed, RANDOM_STREAM_GAMEPLAY);
+	Generator->Count = 0;
+	Generator->GenDistance = Parameters->RectGenStart;
+	Generator->ReachBottom = Generator->ReachTop = FIXED_PLAYER_START_Y;
+	Generator->Redrawn = 0;
+	Generator->GapTop = 0;
+}
+
+fixed GenerateGapTop(struct GapGenerator* Generator)
+{
+	// The time from when the player leaves the last column (or from the
+	// start of the game) to when it enters the next one.
+	uint32_t Between;
+	if (Generator->Count == 0)
+		Between = ScrollTime(Generator, FIXED_FIELD_WIDTH + Generator->Parameters.FieldScroll - FIXED_PLAYER_X - COLLISION_A_HALF_WIDTH);
+	else
+	{
+		Between = ScrollTime(Generator, Generator->GenDistance - 2 * COLLISION_A_HALF_WIDTH);
+		Generator->GenDistance += Generator->Parameters.RectGenSpeed;
+		if (Generator->GenDistance < Generator->Parameters.RectGenMin)
+			Generator->GenDistance = Generator->Parameters.RectGenMin;
+	}
+	Generator->Count++;
+	ExpandReach(Generator, Between);
+
+	fixed TopMin = GapTopMin(Generator), TopMax = GapTopMax(Generator);
+	fixed GapTop = TopMin + (fixed) RandomBelow(&Generator->Gameplay, TopMax - TopMin);
+	if (!ClipReach(Generator, GapTop))
+	{
+		// Draw it again among the gaps that overlap the reachable heights.
+		// There are some, because the player could reach the last gap,
+		// unless the parameters don't let the player rise or fall enough to
+		// reach any; the gap is then kept.
+		fixed Min = Generator->ReachBottom + GAP_MARGIN,
+		      Max = Generator->ReachTop - GAP_MARGIN + Generator->Parameters.GapHeight;
+		if (Min < TopMin)
+			Min = TopMin;
+		if (Max > TopMax - 1)
+			Max = TopMax - 1;
+		if (Min <= Max)
+		{
+			GapTop = Min + (fixed) RandomBelow(&Generator->Gameplay, Max - Min + 1);
+			ClipReach(Generator, GapTop);
+			Generator->Redrawn++;
+		}
+	}
+
+	// Then the player crosses the column, staying within its gap.
+	ExpandReach(Generator, ScrollTime(Generator, FIXED_RECT_WIDTH + 2 * COLLISION_A_HALF_WIDTH));
+	ClipReach(Generator, GapTop);
+	Generator->GapTop = GapTop;
+	return GapTop;
+}
+
+void InitializeGapQueue(struct GapQueue* Queue)
+{
+	Queue->Head = Queue->Tail = 0;
+}
+
+bool PushGap(struct GapQueue* Queue, const struct GapGenerator* Generator)
+{
+	uint32_t Tail = Queue->Tail;
+	if (Tail - Queue->Head == GAP_QUEUE_CAPACITY)
+		return false;
+	Queue->Gaps[Tail & (GAP_QUEUE_CAPACITY - 1)] = *Generator;
+	// The gap must be visible to the reader before the new tail is.
+	__sync_synchronize();
+	Queue->Tail = Tail + 1;
+	return true;
+}
+
+bool PopGap(struct GapQueue* Queue, struct GapGenerator* Generator)
+{
+	uint32_t Head = Queue->Head;
+	if (Queue->Tail == Head)
+		return false;
+	__sync_synchronize();
+	*Generator = Queue->Gaps[Head & (GAP_QUEUE_CAPACITY - 1)];
+	// The gap must be read before the writer can overwrite it.
+	__sync_synchronize();
+	Queue->Head = Head + 1;
+	return true;
+}
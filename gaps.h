@@ -0,0 +1,92 @@
+/*
+ * Hocoslamfy, column gap generator header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _GAPS_H_
+#define _GAPS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed.h"
+#include "rng.h"
+#include "params.h"
+
+// Generates where the gaps of a game's columns are, one column after the
+// other, from the game's seed.
+// Where the columns are and when they appear only depends on time (see
+// GenerateRectangles in sim.c), so the generator knows how long the player
+// has between one column and the next without the rest of the game. It keeps
+// track of the heights the player's center can be at when it leaves the last
+// column, and if a new gap can't be reached from there by boosting or by
+// falling in time, it's drawn again among those that can.
+// The gaps only depend on the seed, so they can be generated ahead of the
+// game, in another thread.
+struct GapGenerator
+{
+	// The parameters of the game, copied so that the generator can be used
+	// on its own, in any thread.
+	struct GameParameters Parameters;
+	struct Random Gameplay;
+	uint32_t      Count;
+	// The horizontal distance from the last column to the next one.
+	fixed         GenDistance;
+	// The lowest and highest the player's center can be when it leaves the
+	// last column.
+	fixed         ReachBottom;
+	fixed         ReachTop;
+	// The number of gaps that had to be drawn again.
+	uint32_t      Redrawn;
+	// The top of the last gap generated.
+	fixed         GapTop;
+};
+
+extern void InitializeGapGenerator(struct GapGenerator* Generator, uint64_t Seed, const struct GameParameters* Parameters);
+
+// Returns the top of the gap of the next column.
+extern fixed GenerateGapTop(struct GapGenerator* Generator);
+
+// The number of gaps that can be generated ahead of a game. It must be a
+// power of 2.
+#define GAP_QUEUE_CAPACITY 512
+
+// A queue of gaps generated ahead of a game, written by one thread and read
+// by another without locks. Each gap is queued as the state of the generator
+// just after generating it, so that the reader's generator can be kept as if
+// it had generated the gap itself. Head is only written by the reader, and
+// Tail only by the writer.
+struct GapQueue
+{
+	struct GapGenerator Gaps[GAP_QUEUE_CAPACITY];
+	volatile uint32_t   Head;
+	volatile uint32_t   Tail;
+};
+
+extern void InitializeGapQueue(struct GapQueue* Queue);
+
+// Adds the last gap generated by Generator at the end of a queue. Returns
+// false if the queue is full. Only one thread may call this for a given
+// queue.
+extern bool PushGap(struct GapQueue* Queue, const struct GapGenerator* Generator);
+
+// Removes the gap at the start of a queue, setting *Generator to the state
+// of the generator that generated it. Returns false if the queue is empty.
+// Only one thread may call this for a given queue.
+extern bool PopGap(struct GapQueue* Queue, struct GapGenerator* Generator);
+
+#endif /* !defined(_GAPS_H_) */
@@ -28,6 +28,7 @@
 #include "audio.h"
 #include "platform.h"
 #include "title.h"
+#include "lookahead.h"
 
 static const char* BackgroundImageNames[BG_LAYER_COUNT] = {
 	"Sky.png",
@@ -73,13 +74,136 @@ static bool CheckImage(bool* Continue, bool* Error, const SDL_Surface* Image, co
 	}
 }
 
+// How many pixels of an image are fully transparent, partly transparent and
+// opaque.
+struct AlphaHistogram
+{
+	uint32_t Transparent;
+	uint32_t Translucent;
+	uint32_t Opaque;
+};
+
+// Image must be 32 bits per pixel, with alpha.
+static struct AlphaHistogram GetAlphaHistogram(SDL_Surface* Image)
+{
+	struct AlphaHistogram Result = { 0, 0, 0 };
+	const Uint32 Amask = Image->format->Amask;
+	int x, y;
+
+	if (SDL_MUSTLOCK(Image))
+		SDL_LockSurface(Image);
+	for (y = 0; y < Image->h; y++)
+	{
+		const Uint32* Row = (const Uint32*) ((const Uint8*) Image->pixels + y * Image->pitch);
+		for (x = 0; x < Image->w; x++)
+		{
+			Uint32 Alpha = Row[x] & Amask;
+			if (Alpha == 0)
+				Result.Transparent++;
+			else if (Alpha == Amask)
+				Result.Opaque++;
+			else
+				Result.Translucent++;
+		}
+	}
+	if (SDL_MUSTLOCK(Image))
+		SDL_UnlockSurface(Image);
+	return Result;
+}
+
+// Looks for a color that no opaque pixel of an image has, to use as its color
+// key, and paints the transparent pixels with it. Image must be 32 bits per
+// pixel, with alpha, and locked.
+static bool PaintColorKey(SDL_Surface* Image, Uint8* R, Uint8* G, Uint8* B)
+{
+	const Uint32 Amask = Image->format->Amask;
+	uint32_t Try;
+	int x, y;
+
+	// Magenta first, then darker ones.
+	for (Try = 0; Try < 16; Try++)
+	{
+		Uint32 Key = SDL_MapRGB(Image->format, 255 - Try, 0, 255 - Try) & ~Amask;
+		bool Used = false;
+		for (y = 0; y < Image->h && !Used; y++)
+		{
+			const Uint32* Row = (const Uint32*) ((const Uint8*) Image->pixels + y * Image->pitch);
+			for (x = 0; x < Image->w && !Used; x++)
+				Used = (Row[x] & Amask) != 0 && (Row[x] & ~Amask) == Key;
+		}
+		if (Used)
+			continue;
+		for (y = 0; y < Image->h; y++)
+		{
+			Uint32* Row = (Uint32*) ((Uint8*) Image->pixels + y * Image->pitch);
+			for (x = 0; x < Image->w; x++)
+				if ((Row[x] & Amask) == 0)
+					Row[x] = Key;
+		}
+		*R = 255 - Try;  *G = 0;  *B = 255 - Try;
+		return true;
+	}
+	return false;
+}
+
+// Converts an image to the screen's pixel format. Images with alpha are
+// converted depending on which alpha values their pixels have, so that blits
+// skip what they can:
+// - those whose pixels are all opaque lose their alpha, and are copied;
+// - those whose pixels are all opaque or fully transparent get a color key
+//   and are run-length encoded, so that blits skip transparent runs and copy
+//   opaque ones;
+// - the others keep per-pixel alpha, but are also run-length encoded, so
+//   that only the partly transparent pixels are blended.
 static SDL_Surface* ConvertSurface(bool* Continue, bool* Error, SDL_Surface* Source, const char* Name)
 {
 	SDL_Surface* Dest;
+	const char* How = "an opaque image";
 	if (Source->format->Amask != 0)
 		Dest = SDL_DisplayFormatAlpha(Source);
 	else
 		Dest = SDL_DisplayFormat(Source);
+	if (Dest != NULL && Dest->format->Amask != 0)
+	{
+		struct AlphaHistogram Histogram = GetAlphaHistogram(Dest);
+		uint32_t Total = Dest->w * Dest->h;
+		Uint8 R, G, B;
+		bool Keyed = false, Opaque = false;
+
+		printf("%s: %u%% transparent, %u%% translucent, %u%% opaque\n", Name,
+			Total ? Histogram.Transparent * 100 / Total : 0,
+			Total ? Histogram.Translucent * 100 / Total : 0,
+			Total ? Histogram.Opaque * 100 / Total : 0);
+		if (Histogram.Translucent == 0)
+		{
+			if (SDL_MUSTLOCK(Dest))
+				SDL_LockSurface(Dest);
+			Keyed = Histogram.Transparent != 0 && PaintColorKey(Dest, &R, &G, &B);
+			if (SDL_MUSTLOCK(Dest))
+				SDL_UnlockSurface(Dest);
+			Opaque = Histogram.Transparent == 0 || Keyed;
+		}
+		if (Opaque)
+		{
+			// Copy the colors as they are, without blending them over black.
+			// If that fails, so does the conversion.
+			SDL_Surface* WithoutAlpha;
+			SDL_SetAlpha(Dest, 0, SDL_ALPHA_OPAQUE);
+			WithoutAlpha = SDL_DisplayFormat(Dest);
+			SDL_FreeSurface(Dest);
+			Dest = WithoutAlpha;
+			if (Dest != NULL && Keyed)
+			{
+				SDL_SetColorKey(Dest, SDL_SRCCOLORKEY | SDL_RLEACCEL, SDL_MapRGB(Dest->format, R, G, B));
+				How = "a color-keyed RLE image";
+			}
+		}
+		else
+		{
+			SDL_SetAlpha(Dest, SDL_SRCALPHA | SDL_RLEACCEL, SDL_ALPHA_OPAQUE);
+			How = "an alpha-blended RLE image";
+		}
+	}
 	if (Dest == NULL)
 	{
 		*Continue = false;  *Error = true;
@@ -89,7 +213,7 @@ static SDL_Surface* ConvertSurface(bool* Continue, bool* Error, SDL_Surface* Sou
 	}
 	else
 	{
-		printf("Successfully converted %s to the screen's pixel format\n", Name);
+		printf("Successfully converted %s to the screen's pixel format, as %s\n", Name, How);
 		SDL_FreeSurface(Source);
 		return Dest;
 	}
@@ -140,6 +264,11 @@ void Initialize(bool* Continue, bool* Error)
 		if ((BackgroundImages[i] = ConvertSurface(Continue, Error, BackgroundImages[i], BackgroundImageNames[i])) == NULL)
 			return;
 	}
+	if (!PrepareBackground())
+	{
+		*Continue = false;  *Error = true;
+		return;
+	}
 
 	for (i = 0; i < TITLE_FRAME_COUNT; i++)
 	{
@@ -171,6 +300,21 @@ void Initialize(bool* Continue, bool* Error)
 	if ((GameOverFrame = ConvertSurface(Continue, Error, GameOverFrame, "GameOverHeader.png")) == NULL)
 		return;
 
+	for (i = 0; i < TITLE_FRAME_COUNT; i++)
+		if ((TitleScreenSprites[i] = CreateSpanSprite(TitleScreenFrames[i], TitleScreenFrameNames[i])) == NULL)
+		{
+			*Continue = false;  *Error = true;
+			return;
+		}
+	if ((GameOverSprite = CreateSpanSprite(GameOverFrame, "GameOverHeader.png")) == NULL
+	 || (CharacterSprite = CreateSpanSprite(CharacterFrames, "Bee.png")) == NULL
+	 || (CollisionSprite = CreateSpanSprite(CollisionImage, "Crash.png")) == NULL
+	 || (ColumnSprite = CreateSpanSprite(ColumnImage, "Bamboo.png")) == NULL)
+	{
+		*Continue = false;  *Error = true;
+		return;
+	}
+
 	InitializePlatform();
 	if (!InitializeAudio())
 	{
@@ -187,8 +331,10 @@ void Initialize(bool* Continue, bool* Error)
 void Finalize()
 {
 	uint32_t i;
+	StopGapLookahead();
 	StopBGM();
 	FinalizeAudio();
+	FreeBackground();
 	for (i = 0; i < BG_LAYER_COUNT; i++)
 	{
 		SDL_FreeSurface(BackgroundImages[i]);
@@ -196,9 +342,19 @@ void Finalize()
 	}
 	for (i = 0; i < TITLE_FRAME_COUNT; i++)
 	{
+		FreeSpanSprite(TitleScreenSprites[i]);
+		TitleScreenSprites[i] = NULL;
 		SDL_FreeSurface(TitleScreenFrames[i]);
 		TitleScreenFrames[i] = NULL;
 	}
+	FreeSpanSprite(GameOverSprite);
+	GameOverSprite = NULL;
+	FreeSpanSprite(CharacterSprite);
+	CharacterSprite = NULL;
+	FreeSpanSprite(CollisionSprite);
+	CollisionSprite = NULL;
+	FreeSpanSprite(ColumnSprite);
+	ColumnSprite = NULL;
 	SDL_FreeSurface(CharacterFrames);
 	CharacterFrames = NULL;
 	SDL_FreeSurface(ColumnImage);
@@ -0,0 +1,94 @@
+/*
+ * Hocoslamfy, gap look-ahead code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "SDL.h"
+
+#include "gaps.h"
+#include "lookahead.h"
+
+// How long the thread sleeps when the queue is full, unless it's stopped. A
+// column is taken from it about twice a second at most.
+#define LOOKAHEAD_DELAY   50
+
+// The number of gaps queued before a game starts, so that its first columns
+// don't wait for the thread. The thread queues the rest.
+#define LOOKAHEAD_PREFILL 4
+
+static SDL_Thread*         Thread      = NULL;
+static SDL_sem*            Wake        = NULL;
+static volatile bool       Stop        = false;
+
+// The generator's last gap is always the next one to add to the queue.
+static struct GapGenerator Generator;
+static struct GapQueue     Queue;
+
+static int Produce(void* Data)
+{
+	while (!Stop)
+	{
+		if (PushGap(&Queue, &Generator))
+			GenerateGapTop(&Generator);
+		else
+			SDL_SemWaitTimeout(Wake, LOOKAHEAD_DELAY);
+	}
+	return 0;
+}
+
+struct GapQueue* StartGapLookahead(uint64_t Seed, const struct GameParameters* Parameters)
+{
+	StopGapLookahead();
+
+	InitializeGapGenerator(&Generator, Seed, Parameters);
+	InitializeGapQueue(&Queue);
+	GenerateGapTop(&Generator);
+
+	Stop = false;
+	if ((Wake = SDL_CreateSemaphore(0)) == NULL
+	 || (Thread = SDL_CreateThread(Produce, NULL)) == NULL)
+	{
+		printf("Failed to start generating gaps ahead of the game: %s\n", SDL_GetError());
+		if (Wake != NULL)
+		{
+			SDL_DestroySemaphore(Wake);
+			Wake = NULL;
+		}
+		return NULL;
+	}
+	while (Queue.Tail < LOOKAHEAD_PREFILL)
+		SDL_Delay(1);
+	return &Queue;
+}
+
+void StopGapLookahead(void)
+{
+	if (Thread != NULL)
+	{
+		Stop = true;
+		SDL_SemPost(Wake);
+		SDL_WaitThread(Thread, NULL);
+		Thread = NULL;
+		SDL_DestroySemaphore(Wake);
+		Wake = NULL;
+	}
+}
@@ -0,0 +1,37 @@
+/*
+ * Hocoslamfy, gap look-ahead header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _LOOKAHEAD_H_
+#define _LOOKAHEAD_H_
+
+#include <stdint.h>
+
+#include "gaps.h"
+
+// Starts generating the gaps of a game with the given seed and parameters
+// ahead of it, in another thread, after stopping the one for the previous
+// game if there was one. This returns once the first few gaps are queued.
+// Returns the queue to take the gaps from (see GameState.GapQueue), or NULL
+// if the thread could not be started.
+extern struct GapQueue* StartGapLookahead(uint64_t Seed, const struct GameParameters* Parameters);
+
+// Stops the thread, such as when the game stops taking gaps from its queue.
+extern void StopGapLookahead(void);
+
+#endif /* !defined(_LOOKAHEAD_H_) */
@@ -19,12 +19,23 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
 
 #include "SDL.h"
 
 #include "main.h"
 #include "init.h"
 #include "platform.h"
+#include "game.h"
+#include "controller.h"
+#include "soak.h"
+#include "catalog.h"
+#include "dirty.h"
+#include "title.h"
 #include "SDL_image.h"
 
 static bool         Continue                             = true;
@@ -37,26 +48,119 @@ static bool         Error                                = false;
        SDL_Surface* ColumnImage                          = NULL;
        SDL_Surface* CollisionImage                       = NULL;
        SDL_Surface* GameOverFrame                        = NULL;
+struct SpanSprite*  TitleScreenSprites[TITLE_FRAME_COUNT] = { NULL };
+struct SpanSprite*  GameOverSprite                       = NULL;
+struct SpanSprite*  CharacterSprite                      = NULL;
+struct SpanSprite*  ColumnSprite                         = NULL;
+struct SpanSprite*  CollisionSprite                      = NULL;
 
        TGatherInput GatherInput;
        TDoLogic     DoLogic;
        TOutputFrame OutputFrame;
+       float        FrameInterpolation                   = 1.0f;
 
 int main(int argc, char* argv[])
 {
+	const char* ReplayPath = NULL;
+	const char* CatalogPath = NULL;
+	bool        SeedGiven  = false;
+	uint64_t    Seed       = 0;
+	bool        Uncapped   = false;
+	bool        Autopilot  = false;
+	double      SoakHours  = 0.0;
+	int         i;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+			ReplayPath = argv[++i];
+		else if (strcmp(argv[i], "--uncapped") == 0)
+			Uncapped = true;
+		else if (strcmp(argv[i], "--autopilot") == 0)
+			Autopilot = true;
+		else if (strcmp(argv[i], "--practice") == 0)
+			SetPracticeMode(true);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+		{
+			Seed = strtoull(argv[++i], NULL, 10);
+			SeedGiven = true;
+		}
+		else if (strcmp(argv[i], "--catalog") == 0 && i + 1 < argc)
+			CatalogPath = argv[++i];
+		else if (strcmp(argv[i], "--dirty-limit") == 0 && i + 1 < argc)
+			SetDirtyLimit(strtoul(argv[++i], NULL, 10));
+		else if (strcmp(argv[i], "--soak") == 0 && i + 1 < argc && (SoakHours = strtod(argv[++i], NULL)) > 0.0)
+			;
+		else
+			break;
+	}
+	if (i < argc || (CatalogPath != NULL && !SeedGiven))
+	{
+		printf("Usage: %s [--replay FILE [--uncapped] | --autopilot | --practice | --soak HOURS] [--seed SEED [--catalog FILE]] [--dirty-limit PERCENT]\n", argv[0]);
+		return 2;
+	}
+
+	if (SeedGiven)
+	{
+		SetGameSeed(Seed);
+		struct SeedRating Rating;
+		if (CatalogPath != NULL && FindSeedRating(CatalogPath, Seed, &Rating))
+		{
+			printf("Seed %" PRIu64 ": harder than %u%% of the seeds in %s; the bot passed %" PRIu32 " columns in %.1f%% of %" PRIu32 " games\n",
+				Seed, (unsigned int) Rating.Difficulty, CatalogPath,
+				CatalogCheckpoints[1], Rating.Survival[1] / 100.0, Rating.Plays);
+			SetTitleSeedRating(&Rating);
+		}
+		else if (CatalogPath != NULL)
+			printf("Seed %" PRIu64 " is not in %s\n", Seed, CatalogPath);
+	}
+
 	Initialize(&Continue, &Error);
-	Uint32 Duration = 16;
+	if (Continue && ReplayPath != NULL && !ToReplay(ReplayPath, Uncapped))
+	{
+		Continue = false;  Error = true;
+	}
+	if (Autopilot)
+		SetGameController(AutopilotController, NULL);
+	// A soak test plays frames of the usual length, drawing them but without
+	// waiting for the next one.
+	bool Soak = Continue && SoakHours > 0.0 && ReplayPath == NULL;
+	if (Soak)
+	{
+		StartSoak((uint32_t) (SoakHours * 3600));
+		ToSoakTest();
+	}
+	// Uncapped replays are played in frames of the usual length, but without
+	// drawing them or waiting for the next one.
+	Uncapped = Uncapped && ReplayPath != NULL;
+	Uint32 Duration = Soak ? SOAK_FRAME_DURATION : 16, Accumulator = 0;
 	while (Continue)
 	{
 		GatherInput(&Continue);
 		if (!Continue)
 			break;
-		DoLogic(&Continue, &Error, Duration);
+		Accumulator += Duration;
+		if (Accumulator > MAX_LOGIC_CATCHUP)
+			Accumulator = MAX_LOGIC_CATCHUP;
+		while (Continue && Accumulator >= LOGIC_TICK)
+		{
+			DoLogic(&Continue, &Error, LOGIC_TICK);
+			Accumulator -= LOGIC_TICK;
+		}
 		if (!Continue)
 			break;
-		OutputFrame();
-		Duration = ToNextFrame();
+		if (!Uncapped)
+		{
+			FrameInterpolation = (float) Accumulator / LOGIC_TICK;
+			OutputFrame();
+			if (Soak)
+				SoakFrame(&Continue);
+			else
+				Duration = ToNextFrame();
+		}
 	}
+	if (Soak)
+		FinishSoak();
 	Finalize();
 	return Error ? 1 : 0;
 }
@@ -25,6 +25,14 @@
 
 #include "title.h"
 #include "bg.h"
+#include "sprite.h"
+
+// The game logic is run in ticks of this many milliseconds, whatever the frame
+// rate, so that it plays the same at 60 Hz and at 144 Hz.
+#define LOGIC_TICK        4
+// The longest time that is caught up on after a frame. If the program was
+// stopped for longer than this, the game is slowed down instead.
+#define MAX_LOGIC_CATCHUP 250
 
 typedef void (*TGatherInput) (bool* Continue);
 typedef void (*TDoLogic) (bool* Continue, bool* Error, Uint32 Milliseconds);
@@ -37,8 +45,21 @@ extern SDL_Surface* CharacterFrames;
 extern SDL_Surface* ColumnImage;
 extern SDL_Surface* CollisionImage;
 extern SDL_Surface* GameOverFrame;
+// Span sprites made from the images with alpha that are drawn over the
+// background.
+extern struct SpanSprite* TitleScreenSprites[TITLE_FRAME_COUNT];
+extern struct SpanSprite* GameOverSprite;
+extern struct SpanSprite* CharacterSprite;
+extern struct SpanSprite* ColumnSprite;
+extern struct SpanSprite* CollisionSprite;
 extern TGatherInput GatherInput;
 extern TDoLogic     DoLogic;
 extern TOutputFrame OutputFrame;
 
+// How far between the previous logic tick and the next one the frame being
+// drawn is, from 0.0 to 1.0. Frames are drawn with things this far along
+// between where they were before and after the last tick, so that they move
+// smoothly even though the frame rate doesn't match the tick rate.
+extern float        FrameInterpolation;
+
 #endif /* !defined(_MAIN_H_) */
@@ -0,0 +1,105 @@
+/*
+ * Hocoslamfy, difficulty parameters code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "fixed.h"
+#include "init.h"
+#include "game.h"
+#include "collision.h"
+#include "sim.h"
+#include "params.h"
+
+const struct GameParameters DefaultParameters = {
+	.SpeedBoost   = FIXED_SPEED_BOOST,
+	.Gravity      = FIXED_GRAVITY,
+	.FieldScroll  = FIXED_FIELD_SCROLL,
+	.RectGenStart = FIXED_RECT_GEN_START,
+	.RectGenSpeed = FIXED_RECT_GEN_SPEED,
+	.RectGenMin   = FIXED_RECT_GEN_MIN,
+	.GapHeight    = FIXED_GAP_HEIGHT
+};
+
+const char* const GameParameterNames[GAME_PARAMETER_COUNT] = {
+	"SPEED_BOOST",
+	"GRAVITY",
+	"FIELD_SCROLL",
+	"RECT_GEN_START",
+	"RECT_GEN_SPEED",
+	"RECT_GEN_MIN",
+	"GAP_HEIGHT"
+};
+
+// What the constants in game.h are multiplied by to get the parameters:
+// speeds are per millisecond and accelerations per millisecond squared.
+static const double GameParameterScales[GAME_PARAMETER_COUNT] = {
+	1.0 / 1000, 1.0 / 1000000, 1.0 / 1000, 1.0, 1.0, 1.0, 1.0
+};
+
+static const size_t GameParameterOffsets[GAME_PARAMETER_COUNT] = {
+	offsetof(struct GameParameters, SpeedBoost),
+	offsetof(struct GameParameters, Gravity),
+	offsetof(struct GameParameters, FieldScroll),
+	offsetof(struct GameParameters, RectGenStart),
+	offsetof(struct GameParameters, RectGenSpeed),
+	offsetof(struct GameParameters, RectGenMin),
+	offsetof(struct GameParameters, GapHeight)
+};
+
+int FindGameParameter(const char* Name)
+{
+	int i;
+	for (i = 0; i < GAME_PARAMETER_COUNT; i++)
+		if (strcmp(Name, GameParameterNames[i]) == 0)
+			return i;
+	return -1;
+}
+
+double GetGameParameter(const struct GameParameters* Parameters, int Index)
+{
+	fixed Value = *(const fixed*) ((const char*) Parameters + GameParameterOffsets[Index]);
+	return (double) Value / FIXED_ONE / GameParameterScales[Index];
+}
+
+void SetGameParameter(struct GameParameters* Parameters, int Index, double Value)
+{
+	*(fixed*) ((char*) Parameters + GameParameterOffsets[Index]) = FIXED(Value * GameParameterScales[Index]);
+}
+
+bool CheckGameParameters(const struct GameParameters* Parameters)
+{
+	if (Parameters->SpeedBoost <= 0 || Parameters->Gravity >= 0)
+		fprintf(stderr, "SPEED_BOOST must be positive and GRAVITY negative\n");
+	else if (Parameters->FieldScroll >= 0)
+		fprintf(stderr, "FIELD_SCROLL must be negative\n");
+	else if (Parameters->RectGenStart <= 0 || Parameters->RectGenMin <= 0)
+		fprintf(stderr, "RECT_GEN_START and RECT_GEN_MIN must be positive\n");
+	else if (2 * ((uint32_t) (FIELD_WIDTH / (RECT_WIDTH + (double) Parameters->RectGenMin / FIXED_ONE)) + 3) > RECTANGLE_CAPACITY)
+		fprintf(stderr, "RECT_GEN_MIN is too small for the field to hold the columns\n");
+	else if (Parameters->GapHeight <= 2 * COLLISION_B_HALF_HEIGHT
+	      || Parameters->GapHeight >= FIXED_FIELD_HEIGHT - FIXED_FIELD_HEIGHT / 8)
+		fprintf(stderr, "GAP_HEIGHT must leave room for the player and for the columns\n");
+	else
+		return true;
+	return false;
+}
@@ -0,0 +1,67 @@
+/*
+ * Hocoslamfy, difficulty parameters header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _PARAMS_H_
+#define _PARAMS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed.h"
+
+// The constants of game.h that set how hard a game is, as a block that can be
+// changed at run time, in the fixed-point units of the simulation (see the
+// FIXED_* constants in game.h). The game itself is always played with
+// DefaultParameters; the others are for tools that try variants of it.
+struct GameParameters
+{
+	fixed SpeedBoost;
+	fixed Gravity;
+	fixed FieldScroll;
+	fixed RectGenStart;
+	fixed RectGenSpeed;
+	fixed RectGenMin;
+	fixed GapHeight;
+};
+
+#define GAME_PARAMETER_COUNT 7
+
+// The parameters set by the constants in game.h.
+extern const struct GameParameters DefaultParameters;
+
+// The names of the parameters, which are those of their constants in game.h
+// ("SPEED_BOOST", "GRAVITY" and so on), in the order of GameParameters.
+extern const char* const GameParameterNames[GAME_PARAMETER_COUNT];
+
+// Returns the index of the parameter with the given name, or -1 if there is
+// no such parameter.
+extern int FindGameParameter(const char* Name);
+
+// Gets or sets a parameter in the units of its constant in game.h, such as
+// meters per second for SPEED_BOOST.
+extern double GetGameParameter(const struct GameParameters* Parameters, int Index);
+extern void SetGameParameter(struct GameParameters* Parameters, int Index, double Value);
+
+// Returns false, after printing why, if games can't be played with the given
+// parameters: if the player can't rise or fall, the field doesn't scroll,
+// the gaps don't leave room for the player or the columns can be so close
+// together that RECTANGLE_CAPACITY isn't enough for them (see sim.h).
+extern bool CheckGameParameters(const struct GameParameters* Parameters);
+
+#endif /* !defined(_PARAMS_H_) */
@@ -36,6 +36,8 @@ Uint32 ToNextFrame(void);
 //   ExitGame: true if the event can be used to exit the entire application.
 //   Boost: true if the event can be used to boost the player's character.
 //   Pause: true if the event can be used to pause a game in progress.
+//   RewindPressing: true if the event starts rewinding a game in practice
+//     mode, which goes on until the matching RewindReleasing event.
 
 // Get???Prompt returns the text that can be used to describe the actions that
 // can trigger a feature on the platform.
@@ -52,3 +54,7 @@ const char* GetBoostPrompt(void);
 
 bool IsPauseEvent(const SDL_Event* event);
 const char* GetPausePrompt(void);
+
+bool IsRewindPressingEvent(const SDL_Event* event);
+bool IsRewindReleasingEvent(const SDL_Event* event);
+const char* GetRewindPrompt(void);
@@ -92,3 +92,20 @@ const char* GetPausePrompt(void)
 {
 	return "P";
 }
+
+bool IsRewindPressingEvent(const SDL_Event* event)
+{
+	return event->type == SDL_KEYDOWN
+	    && event->key.keysym.sym == SDLK_r;
+}
+
+bool IsRewindReleasingEvent(const SDL_Event* event)
+{
+	return event->type == SDL_KEYUP
+	    && event->key.keysym.sym == SDLK_r;
+}
+
+const char* GetRewindPrompt(void)
+{
+	return "R";
+}
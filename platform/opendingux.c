@@ -90,3 +90,20 @@ const char* GetPausePrompt(void)
 {
 	return "Start";
 }
+
+bool IsRewindPressingEvent(const SDL_Event* event)
+{
+	return event->type == SDL_KEYDOWN
+	    && event->key.keysym.sym == SDLK_TAB /* L */;
+}
+
+bool IsRewindReleasingEvent(const SDL_Event* event)
+{
+	return event->type == SDL_KEYUP
+	    && event->key.keysym.sym == SDLK_TAB /* L */;
+}
+
+const char* GetRewindPrompt(void)
+{
+	return "L";
+}
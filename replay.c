@@ -0,0 +1,215 @@
+/*
+ * Hocoslamfy, replay code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sim.h"
+#include "replay.h"
+
+static const char ReplayMagic[4] = { 'H', 'C', 'R', 'P' };
+
+void InitializeReplay(struct Replay* Replay, uint64_t Seed)
+{
+	Replay->Seed = Seed;
+	Replay->Score = 0;
+	Replay->Duration = 0;
+	Replay->BoostTimes = NULL;
+	Replay->BoostCount = 0;
+	Replay->BoostCapacity = 0;
+}
+
+void FinalizeReplay(struct Replay* Replay)
+{
+	free(Replay->BoostTimes);
+	Replay->BoostTimes = NULL;
+	Replay->BoostCount = 0;
+	Replay->BoostCapacity = 0;
+}
+
+bool RecordBoost(struct Replay* Replay, uint32_t Time)
+{
+	if (Replay->BoostCount == Replay->BoostCapacity)
+	{
+		uint32_t NewCapacity = Replay->BoostCapacity != 0 ? Replay->BoostCapacity * 2 : 256;
+		uint32_t* NewBoostTimes = realloc(Replay->BoostTimes, NewCapacity * sizeof(uint32_t));
+		if (NewBoostTimes == NULL)
+			return false;
+		Replay->BoostTimes = NewBoostTimes;
+		Replay->BoostCapacity = NewCapacity;
+	}
+	Replay->BoostTimes[Replay->BoostCount++] = Time;
+	return true;
+}
+
+static void WriteNumber(FILE* fp, uint64_t Value)
+{
+	while (Value >= 0x80)
+	{
+		fputc((int) (Value & 0x7F) | 0x80, fp);
+		Value >>= 7;
+	}
+	fputc((int) Value, fp);
+}
+
+// Reads a number written by WriteNumber. Returns false if the file ends
+// before it does, or if it's too large for MaxBits bits.
+static bool ReadNumber(FILE* fp, uint64_t* Value, uint32_t MaxBits)
+{
+	uint32_t Shift = 0;
+	int c;
+	*Value = 0;
+	do
+	{
+		if ((c = fgetc(fp)) == EOF || Shift >= MaxBits
+		 || (Shift > 0 && ((uint64_t) (c & 0x7F) >> (MaxBits - Shift)) != 0))
+			return false;
+		*Value |= (uint64_t) (c & 0x7F) << Shift;
+		Shift += 7;
+	} while (c & 0x80);
+	return true;
+}
+
+bool SaveReplay(const struct Replay* Replay, const char* Path)
+{
+	uint32_t i, LastTime = 0;
+	FILE* fp = fopen(Path, "wb");
+
+	if (!fp)
+	{
+		fprintf(stderr, "%s: Unable to open file.\n", Path);
+		return false;
+	}
+
+	fwrite(ReplayMagic, 1, sizeof(ReplayMagic), fp);
+	WriteNumber(fp, REPLAY_VERSION);
+	WriteNumber(fp, Replay->Seed);
+	WriteNumber(fp, Replay->Score);
+	WriteNumber(fp, Replay->Duration);
+	WriteNumber(fp, Replay->BoostCount);
+	for (i = 0; i < Replay->BoostCount; i++)
+	{
+		WriteNumber(fp, Replay->BoostTimes[i] - LastTime);
+		LastTime = Replay->BoostTimes[i];
+	}
+
+	bool Result = !ferror(fp);
+	if (fclose(fp) != 0)
+		Result = false;
+	if (!Result)
+		fprintf(stderr, "%s: Unable to write file.\n", Path);
+	return Result;
+}
+
+bool LoadReplay(struct Replay* Replay, const char* Path)
+{
+	char Magic[sizeof(ReplayMagic)];
+	uint64_t Version, Score = 0, Duration = 0, Count = 0, Delta;
+	uint32_t i, Time = 0;
+	FILE* fp = fopen(Path, "rb");
+
+	InitializeReplay(Replay, 0);
+	if (!fp)
+	{
+		fprintf(stderr, "%s: Unable to open file.\n", Path);
+		return false;
+	}
+
+	if (fread(Magic, 1, sizeof(Magic), fp) != sizeof(Magic)
+	 || memcmp(Magic, ReplayMagic, sizeof(Magic)) != 0
+	 || !ReadNumber(fp, &Version, 32))
+	{
+		fprintf(stderr, "%s: Not a replay file.\n", Path);
+		fclose(fp);
+		return false;
+	}
+	if (Version != REPLAY_VERSION)
+	{
+		fprintf(stderr, "%s: Unsupported replay version %u.\n", Path, (unsigned int) Version);
+		fclose(fp);
+		return false;
+	}
+	bool Valid = ReadNumber(fp, &Replay->Seed, 64)
+	          && ReadNumber(fp, &Score, 32)
+	          && ReadNumber(fp, &Duration, 32)
+	          && ReadNumber(fp, &Count, 32);
+	bool OutOfMemory = false;
+	Replay->Score = (uint32_t) Score;
+	Replay->Duration = (uint32_t) Duration;
+
+	// Boosts can't be given after the end of the game.
+	for (i = 0; Valid && i < Count; i++)
+	{
+		Valid = ReadNumber(fp, &Delta, 32) && Delta <= Replay->Duration - Time;
+		if (Valid)
+		{
+			Time += (uint32_t) Delta;
+			OutOfMemory = !RecordBoost(Replay, Time);
+			Valid = !OutOfMemory;
+		}
+	}
+	fclose(fp);
+
+	if (!Valid)
+	{
+		if (OutOfMemory)
+			fprintf(stderr, "%s: Out of memory.\n", Path);
+		else
+			fprintf(stderr, "%s: Truncated or corrupted replay file.\n", Path);
+		FinalizeReplay(Replay);
+		return false;
+	}
+	return true;
+}
+
+uint32_t AdvanceReplay(struct GameState* State, const struct Replay* Replay, uint32_t* NextBoost, uint32_t Milliseconds)
+{
+	uint32_t Events = 0;
+	// The game's time stops when the player dies, so nothing is left to play.
+	while (Milliseconds > 0 && State->PlayerStatus != DEAD)
+	{
+		bool Boost = *NextBoost < Replay->BoostCount
+		          && Replay->BoostTimes[*NextBoost] <= State->Time;
+		if (Boost)
+			(*NextBoost)++;
+
+		// Stop at the millisecond of the next boost, so that it's given at
+		// the start of a call to AdvanceGameState.
+		uint32_t Steps = Milliseconds;
+		if (*NextBoost < Replay->BoostCount
+		 && Replay->BoostTimes[*NextBoost] > State->Time
+		 && Replay->BoostTimes[*NextBoost] - State->Time < Steps)
+			Steps = Replay->BoostTimes[*NextBoost] - State->Time;
+
+		Events |= AdvanceGameState(State, Boost, Steps);
+		Milliseconds -= Steps;
+	}
+	return Events;
+}
+
+bool ReplayMatches(const struct GameState* State, const struct Replay* Replay, uint32_t NextBoost)
+{
+	return State->PlayerStatus == DEAD
+	    && State->Score == Replay->Score
+	    && State->Time == Replay->Duration
+	    && NextBoost == Replay->BoostCount;
+}
@@ -0,0 +1,79 @@
+/*
+ * Hocoslamfy, replay header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+
+// A game is entirely determined by its seed and by the times at which the
+// player boosted, so that is all a replay holds.
+// In a file, a replay is the 4 bytes "HCRP" followed by unsigned LEB128
+// numbers: the format version (REPLAY_VERSION), the seed, the score and
+// duration of the game, the number of boosts, and then the time of each boost
+// as the number of milliseconds since the previous one (or since the start of
+// the game for the first one).
+struct Replay
+{
+	uint64_t  Seed;
+	// The score the game ended with, and the number of milliseconds it was
+	// played for.
+	uint32_t  Score;
+	uint32_t  Duration;
+	// The values of State->Time at which the player was boosted, in
+	// increasing order.
+	uint32_t* BoostTimes;
+	uint32_t  BoostCount;
+	uint32_t  BoostCapacity;
+};
+
+#define REPLAY_VERSION 2
+
+// Starts an empty replay for a game started with the given seed.
+extern void InitializeReplay(struct Replay* Replay, uint64_t Seed);
+
+extern void FinalizeReplay(struct Replay* Replay);
+
+// Adds a boost given at the given time to a replay.
+// Returns false if memory could not be allocated.
+extern bool RecordBoost(struct Replay* Replay, uint32_t Time);
+
+// Writes a replay to a file. Returns false if the file could not be written.
+extern bool SaveReplay(const struct Replay* Replay, const char* Path);
+
+// Reads a replay from a file into an uninitialised replay. Returns false,
+// after printing why, if the file could not be read or isn't a replay.
+extern bool LoadReplay(struct Replay* Replay, const char* Path);
+
+// Advances a game by the given number of milliseconds, boosting the player at
+// the times given by a replay. *NextBoost is the index in the replay of the
+// next boost to give, which is 0 at the start of the game.
+// Returns as soon as the player is dead, leaving the boosts after that unused.
+// Returns the GAME_EVENT_* bits of the things that happened.
+extern uint32_t AdvanceReplay(struct GameState* State, const struct Replay* Replay, uint32_t* NextBoost, uint32_t Milliseconds);
+
+// Returns whether a game played from a replay, up to its recorded duration,
+// ended the way the replay says: over, at exactly that duration, with the
+// recorded score and after every boost in it.
+extern bool ReplayMatches(const struct GameState* State, const struct Replay* Replay, uint32_t NextBoost);
+
+#endif /* !defined(_REPLAY_H_) */
@@ -0,0 +1,66 @@
+/*
+ * Hocoslamfy, rewind buffer code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "snapshot.h"
+#include "rewind.h"
+
+static struct RunSnapshot* Keyframe(struct RewindBuffer* Buffer, uint32_t Index)
+{
+	return &Buffer->Keyframes[(Buffer->Start + Index) % REWIND_KEYFRAMES];
+}
+
+void ClearRewindBuffer(struct RewindBuffer* Buffer)
+{
+	Buffer->Start = 0;
+	Buffer->Count = 0;
+}
+
+bool NeedsKeyframe(const struct RewindBuffer* Buffer, uint32_t Time)
+{
+	if (Buffer->Count == 0)
+		return true;
+	const struct RunSnapshot* Latest = &Buffer->Keyframes[(Buffer->Start + Buffer->Count - 1) % REWIND_KEYFRAMES];
+	return Time - Latest->Game.Time >= REWIND_KEYFRAME_INTERVAL;
+}
+
+void AddKeyframe(struct RewindBuffer* Buffer, const struct RunSnapshot* Snapshot)
+{
+	if (Buffer->Count == REWIND_KEYFRAMES)
+	{
+		Buffer->Start = (Buffer->Start + 1) % REWIND_KEYFRAMES;
+		Buffer->Count--;
+	}
+	*Keyframe(Buffer, Buffer->Count++) = *Snapshot;
+}
+
+uint32_t GetOldestKeyframeTime(const struct RewindBuffer* Buffer)
+{
+	return Buffer->Keyframes[Buffer->Start].Game.Time;
+}
+
+const struct RunSnapshot* RewindKeyframes(struct RewindBuffer* Buffer, uint32_t Time)
+{
+	while (Buffer->Count > 0 && Keyframe(Buffer, Buffer->Count - 1)->Game.Time > Time)
+		Buffer->Count--;
+	return Buffer->Count > 0 ? Keyframe(Buffer, Buffer->Count - 1) : NULL;
+}
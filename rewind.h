@@ -0,0 +1,65 @@
+/*
+ * Hocoslamfy, rewind buffer header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _REWIND_H_
+#define _REWIND_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "snapshot.h"
+
+// The game being played can be rewound to any time within the last
+// REWIND_TIME milliseconds. Snapshots of it are kept every
+// REWIND_KEYFRAME_INTERVAL milliseconds, and between two of them, the game is
+// played again from the earlier one with the boosts of its replay.
+#define REWIND_TIME              30000
+#define REWIND_KEYFRAME_INTERVAL   250
+#define REWIND_KEYFRAMES         (REWIND_TIME / REWIND_KEYFRAME_INTERVAL + 1)
+
+// How many milliseconds of the game are rewound per millisecond that the
+// rewind key or button is held.
+#define REWIND_SPEED 2
+
+// The snapshots, in a circular buffer of a fixed size, oldest first.
+struct RewindBuffer
+{
+	struct RunSnapshot Keyframes[REWIND_KEYFRAMES];
+	uint32_t           Start;
+	uint32_t           Count;
+};
+
+extern void ClearRewindBuffer(struct RewindBuffer* Buffer);
+
+// Returns true if a snapshot of the game at the given time would be at least
+// REWIND_KEYFRAME_INTERVAL milliseconds after the latest one.
+extern bool NeedsKeyframe(const struct RewindBuffer* Buffer, uint32_t Time);
+
+// Adds a snapshot to a buffer, forgetting the oldest one if it's full.
+extern void AddKeyframe(struct RewindBuffer* Buffer, const struct RunSnapshot* Keyframe);
+
+// Returns the game time of the oldest snapshot in a buffer, which is as far
+// back as the game can be rewound. The buffer must not be empty.
+extern uint32_t GetOldestKeyframeTime(const struct RewindBuffer* Buffer);
+
+// Forgets the snapshots taken after the given time, and returns the latest
+// of those that remain, or NULL if none do.
+extern const struct RunSnapshot* RewindKeyframes(struct RewindBuffer* Buffer, uint32_t Time);
+
+#endif /* !defined(_REWIND_H_) */
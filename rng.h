@@ -0,0 +1,69 @@
+/*
+ * Hocoslamfy, random number generator header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _RNG_H_
+#define _RNG_H_
+
+#include <stdint.h>
+
+// A PCG32 random number generator (see <http://www.pcg-random.org/>).
+// Unlike rand(), each game has its own, so that a game plays out the same way
+// given the same seed on every platform, and games can be played in several
+// threads at once. Generators seeded with the same seed but different streams
+// give unrelated numbers.
+// The functions are defined here so that they can be inlined in the loops of
+// the simulation and the tools.
+struct Random
+{
+	uint64_t State;
+	uint64_t Increment;
+};
+
+// The streams used by a game. The gameplay stream decides where the columns'
+// gaps are; the cosmetic stream only decides what things look like, so that
+// drawing a game differently doesn't change how it plays.
+#define RANDOM_STREAM_GAMEPLAY 0
+#define RANDOM_STREAM_COSMETIC 1
+
+// Returns a random number between 0 and UINT32_MAX.
+static inline uint32_t NextRandom(struct Random* Random)
+{
+	uint64_t State = Random->State;
+	Random->State = State * UINT64_C(6364136223846793005) + Random->Increment;
+	uint32_t XorShifted = (uint32_t) (((State >> 18) ^ State) >> 27);
+	uint32_t Rotation = (uint32_t) (State >> 59);
+	return (XorShifted >> Rotation) | (XorShifted << ((-Rotation) & 31));
+}
+
+// Returns a random number between 0 and Bound - 1.
+static inline uint32_t RandomBelow(struct Random* Random, uint32_t Bound)
+{
+	return (uint32_t) (((uint64_t) NextRandom(Random) * Bound) >> 32);
+}
+
+static inline void SeedRandom(struct Random* Random, uint64_t Seed, uint64_t Stream)
+{
+	Random->State = 0;
+	Random->Increment = (Stream << 1) | 1;
+	NextRandom(Random);
+	Random->State += Seed;
+	NextRandom(Random);
+}
+
+#endif /* !defined(_RNG_H_) */
@@ -35,7 +35,9 @@
 #include "platform.h"
 #include "game.h"
 #include "score.h"
+#include "replay.h"
 #include "bg.h"
+#include "dirty.h"
 #include "text.h"
 #include "audio.h"
 
@@ -43,8 +45,12 @@ static bool  WaitingForRelease = false;
 
 static char* ScoreMessage      = NULL;
 
+static struct ScreenSprite HeaderSprite, MessageSprite;
+
 static const char* SavePath = ".hocoslamfy";
 static const char* HighScoreFilePath = "highscore";
+static const char* ReplayFilePrefix = "replay-";
+static const char* ReplayFileSuffix = ".hcr";
 
 void ScoreGatherInput(bool* Continue)
 {
@@ -83,24 +89,20 @@ void ScoreDoLogic(bool* Continue, bool* Error, Uint32 Milliseconds)
 	AdvanceBackground(Milliseconds);
 }
 
-void ScoreOutputFrame()
+static void DrawScore(const SDL_Rect* HeaderDestRect, const SDL_Rect* MessageRect, const SDL_Rect* Clip)
 {
 	DrawBackground();
 
-	SDL_Rect HeaderDestRect = {
-		.x = (SCREEN_WIDTH - GameOverFrame->w) / 2,
-		.y = ((SCREEN_HEIGHT / 4) - GameOverFrame->h) / 2,
-		.w = GameOverFrame->w,
-		.h = GameOverFrame->h
-	};
 	SDL_Rect HeaderSourceRect = {
 		.x = 0,
 		.y = 0,
 		.w = GameOverFrame->w,
 		.h = GameOverFrame->h
 	};
-	SDL_BlitSurface(GameOverFrame, &HeaderSourceRect, Screen, &HeaderDestRect);
+	BlitSpanSprite(GameOverSprite, &HeaderSourceRect, Screen, HeaderDestRect);
 
+	if (!IsTextBoxIn(MessageRect, Clip))
+		return;
 	if (SDL_MUSTLOCK(Screen))
 		SDL_LockSurface(Screen);
 	PrintStringOutline32(ScoreMessage,
@@ -108,16 +110,47 @@ void ScoreOutputFrame()
 		SDL_MapRGB(Screen->format, 0, 0, 0),
 		Screen->pixels,
 		Screen->pitch,
-		0,
-		SCREEN_HEIGHT / 4,
-		SCREEN_WIDTH,
-		SCREEN_HEIGHT - (SCREEN_HEIGHT / 4),
+		MessageRect->x,
+		MessageRect->y,
+		MessageRect->w,
+		MessageRect->h,
 		CENTER,
 		MIDDLE);
 	if (SDL_MUSTLOCK(Screen))
 		SDL_UnlockSurface(Screen);
+}
+
+void ScoreOutputFrame()
+{
+	SDL_Rect HeaderDestRect = {
+		.x = (SCREEN_WIDTH - GameOverFrame->w) / 2,
+		.y = ((SCREEN_HEIGHT / 4) - GameOverFrame->h) / 2,
+		.w = GameOverFrame->w,
+		.h = GameOverFrame->h
+	};
+	SDL_Rect MessageRect = {
+		.x = 0,
+		.y = SCREEN_HEIGHT / 4,
+		.w = SCREEN_WIDTH,
+		.h = SCREEN_HEIGHT - (SCREEN_HEIGHT / 4)
+	};
+	FitTextBox(&MessageRect, ScoreMessage);
+	const SDL_Rect* Rects;
+	uint32_t Count, i;
 
-	SDL_Flip(Screen);
+	UpdateBackgroundSprites();
+	UpdateSprite(&HeaderSprite, &HeaderDestRect, 0);
+	// The message only changes while the score screen isn't shown.
+	UpdateTextSprite(&MessageSprite, &MessageRect, 0);
+
+	Count = GetDirtyRects(&Rects);
+	for (i = 0; i < Count; i++)
+	{
+		SDL_SetClipRect(Screen, &Rects[i]);
+		DrawScore(&HeaderDestRect, &MessageRect, &Rects[i]);
+	}
+	SDL_SetClipRect(Screen, NULL);
+	PresentFrame();
 }
 
 void ToScore(uint32_t Score, enum GameOverReason GameOverReason, uint32_t HighScore)
@@ -156,6 +189,7 @@ void ToScore(uint32_t Score, enum GameOverReason GameOverReason, uint32_t HighSc
 		ScoreMessage = realloc(ScoreMessage, Length);
 	}
 
+	InvalidateScreen();
 	GatherInput = ScoreGatherInput;
 	DoLogic     = ScoreDoLogic;
 	OutputFrame = ScoreOutputFrame;
@@ -195,6 +229,22 @@ void SaveHighScore(uint32_t Score)
 	fclose(fp);
 }
 
+void SaveRunReplay(const struct Replay* Replay)
+{
+	char path[256];
+#ifndef DONT_USE_PWD
+	struct passwd *pw = getpwuid(getuid());
+	
+	snprintf(path, 256, "%s/%s", pw->pw_dir, SavePath);
+	MkDir(path);
+	
+	snprintf(path, 256, "%s/%s/%s%016" PRIx64 "%s", pw->pw_dir, SavePath, ReplayFilePrefix, Replay->Seed, ReplayFileSuffix);
+#else
+	snprintf(path, 256, "%s%016" PRIx64 "%s", ReplayFilePrefix, Replay->Seed, ReplayFileSuffix);
+#endif
+	SaveReplay(Replay, path);
+}
+
 void GetFileLine(char *str, uint32_t size, FILE *fp)
 {
 	int i = 0;
@@ -21,15 +21,15 @@
 #define _SCORE_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 
-enum GameOverReason
-{
-	FIELD_BORDER_COLLISION,
-	RECTANGLE_COLLISION
-};
+#include "sim.h"
+#include "replay.h"
 
 extern void ToScore(uint32_t Score, enum GameOverReason GameOverReason, uint32_t HighScore);
 extern void SaveHighScore(uint32_t Score);
+// Saves the replay of a game next to the high score, named after its seed.
+extern void SaveRunReplay(const struct Replay* Replay);
 extern uint32_t GetHighScore(void);
 
 #endif /* !defined(_SCORE_H_) */
@@ -0,0 +1,597 @@
+/*
+ * Hocoslamfy, game simulation code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <sched.h>
+
+#include "init.h"
+#include "game.h"
+#include "sim.h"
+#include "collision.h"
+
+void SaveGameState(const struct GameState* State, struct GameSnapshot* Snapshot)
+{
+	const struct HocoslamfyRects* Rectangles = &State->Rectangles;
+	// The slots from RectangleStart to the end of the buffer, then the ones
+	// that wrapped around to its start. Unused slots are cleared, so they're
+	// copied too.
+	uint32_t End = RECTANGLE_CAPACITY - State->RectangleStart, Start = State->RectangleStart, i;
+
+	Snapshot->Score = State->Score;
+	Snapshot->Time = State->Time;
+	Snapshot->PlayerStatus = State->PlayerStatus;
+	Snapshot->GameOverReason = State->GameOverReason;
+	Snapshot->CollisionTime = State->CollisionTime;
+	Snapshot->PlayerX = State->PlayerX;
+	Snapshot->PlayerY = State->PlayerY;
+	Snapshot->PlayerSpeed = State->PlayerSpeed;
+	Snapshot->RectangleCount = State->RectangleCount;
+	Snapshot->RectangleCursor = State->RectangleCursor;
+	Snapshot->GenDistance = State->GenDistance;
+	Snapshot->FieldTime = State->FieldTime;
+	Snapshot->FieldEvents = (struct FieldEventQueue) { .Start = 0, .Count = State->FieldEvents.Count };
+	for (i = 0; i < State->FieldEvents.Count; i++)
+	{
+		Snapshot->FieldEvents.Events[i] = *GetFieldEvent(&State->FieldEvents, i);
+		Snapshot->FieldEvents.Events[i].Slot = (Snapshot->FieldEvents.Events[i].Slot - Start) & (RECTANGLE_CAPACITY - 1);
+	}
+	Snapshot->Seed = State->Seed;
+	Snapshot->Gaps = State->Gaps;
+	Snapshot->Cosmetic = State->Cosmetic;
+	memcpy(Snapshot->Left,   Rectangles->Left   + Start, End * sizeof(fixed));
+	memcpy(Snapshot->Left   + End, Rectangles->Left,   Start * sizeof(fixed));
+	memcpy(Snapshot->Top,    Rectangles->Top    + Start, End * sizeof(fixed));
+	memcpy(Snapshot->Top    + End, Rectangles->Top,    Start * sizeof(fixed));
+	memcpy(Snapshot->Right,  Rectangles->Right  + Start, End * sizeof(fixed));
+	memcpy(Snapshot->Right  + End, Rectangles->Right,  Start * sizeof(fixed));
+	memcpy(Snapshot->Bottom, Rectangles->Bottom + Start, End * sizeof(fixed));
+	memcpy(Snapshot->Bottom + End, Rectangles->Bottom, Start * sizeof(fixed));
+	memcpy(Snapshot->Passed, Rectangles->Passed + Start, End * sizeof(bool));
+	memcpy(Snapshot->Passed + End, Rectangles->Passed, Start * sizeof(bool));
+	memcpy(Snapshot->Frame,  Rectangles->Frame  + Start, End * sizeof(uint8_t));
+	memcpy(Snapshot->Frame  + End, Rectangles->Frame,  Start * sizeof(uint8_t));
+}
+
+void LoadGameState(struct GameState* State, const struct GameSnapshot* Snapshot)
+{
+	struct HocoslamfyRects* Rectangles = &State->Rectangles;
+
+	State->Score = Snapshot->Score;
+	State->Time = Snapshot->Time;
+	State->PlayerStatus = Snapshot->PlayerStatus;
+	State->GameOverReason = Snapshot->GameOverReason;
+	State->CollisionTime = Snapshot->CollisionTime;
+	State->PlayerX = Snapshot->PlayerX;
+	State->PlayerY = Snapshot->PlayerY;
+	State->PlayerSpeed = Snapshot->PlayerSpeed;
+	State->RectangleStart = 0;
+	State->RectangleCount = Snapshot->RectangleCount;
+	State->RectangleCursor = Snapshot->RectangleCursor;
+	State->GenDistance = Snapshot->GenDistance;
+	State->FieldTime = Snapshot->FieldTime;
+	State->FieldEvents = Snapshot->FieldEvents;
+	State->Seed = Snapshot->Seed;
+	State->Gaps = Snapshot->Gaps;
+	State->Cosmetic = Snapshot->Cosmetic;
+	State->GapQueue = NULL;
+	memcpy(Rectangles->Left,   Snapshot->Left,   sizeof(Snapshot->Left));
+	memcpy(Rectangles->Top,    Snapshot->Top,    sizeof(Snapshot->Top));
+	memcpy(Rectangles->Right,  Snapshot->Right,  sizeof(Snapshot->Right));
+	memcpy(Rectangles->Bottom, Snapshot->Bottom, sizeof(Snapshot->Bottom));
+	memcpy(Rectangles->Passed, Snapshot->Passed, sizeof(Snapshot->Passed));
+	memcpy(Rectangles->Frame,  Snapshot->Frame,  sizeof(Snapshot->Frame));
+	SetAllHitboxes(&Rectangles->Hitboxes, RECTANGLE_CAPACITY,
+		Rectangles->Left, Rectangles->Top, Rectangles->Right, Rectangles->Bottom);
+}
+
+uint32_t RectangleSlot(const struct GameState* State, uint32_t Index)
+{
+	return (State->RectangleStart + Index) & (State->RectangleCapacity - 1);
+}
+
+static void ClearRectangleSlot(struct GameState* State, uint32_t Slot)
+{
+	// Left of the field, and with no height; nothing can collide with this.
+	State->Rectangles.Left[Slot] = State->Rectangles.Right[Slot] = -FIXED_RECT_WIDTH;
+	State->Rectangles.Top[Slot] = State->Rectangles.Bottom[Slot] = 0;
+	State->Rectangles.Passed[Slot] = true;
+	State->Rectangles.Frame[Slot] = 0;
+	SetHitboxes(&State->Rectangles.Hitboxes, Slot, -FIXED_RECT_WIDTH, 0, -FIXED_RECT_WIDTH, 0);
+}
+
+// The ALIVE logic below advances the game by whole frames at once instead of
+// looping once per elapsed millisecond. The rules are still those of a
+// simulation stepped every millisecond, in this order:
+//   a) scroll all rectangles by Parameters.FieldScroll, award points for those
+//      that went past the player and remove those that went past the left
+//      side;
+//   b) generate a pair of rectangles if needed;
+//   c) update the player's speed by Parameters.Gravity, or set it to
+//      Parameters.SpeedBoost;
+//   d) move the player by PlayerSpeed and check for collisions.
+// After k such steps, the positions of everything have closed forms, so the
+// step at which something happens can be solved for directly. The closed
+// forms are evaluated in integers, so they give exactly the same results as
+// stepping would, on every platform. Only the search for the steps at which
+// things may happen uses floating-point.
+
+// The maximum number of steps that are examined around the steps at which the
+// terms of a collision test may change: 3 per root, for 4 horizontal roots and
+// 8 vertical roots for the hitboxes of each of a group of 4 rectangles, plus
+// the first step.
+#define MAX_CANDIDATE_STEPS (1 + 3 * 4 * (4 + 8))
+
+// Clamps a position to the range of fixed-point numbers. Positions outside
+// of it are far outside of the field anyway.
+static fixed SaturateFixed(int64_t Value)
+{
+	return Value > INT32_MAX ? INT32_MAX : Value < INT32_MIN ? INT32_MIN : (fixed) Value;
+}
+
+// Returns the height of the player after Steps more milliseconds of flight
+// starting at PlayerY and PlayerSpeed, per c) and d) above.
+static fixed PlayerYAfter(const struct GameState* State, uint32_t Steps)
+{
+	return SaturateFixed((int64_t) State->PlayerY + (int64_t) Steps * State->PlayerSpeed
+		+ (int64_t) State->Parameters.Gravity * ((int64_t) Steps * (Steps + 1) / 2));
+}
+
+// Returns the horizontal position of an edge of a rectangle after Steps more
+// milliseconds of scrolling.
+static fixed EdgeXAfter(const struct GameState* State, fixed X, uint32_t Steps)
+{
+	return SaturateFixed((int64_t) X + (int64_t) Steps * State->Parameters.FieldScroll);
+}
+
+// Adds the steps around a real-valued step, at which a term of a test becomes
+// true or false, to the list of steps at which the test may start to hold.
+static void AddCandidateSteps(uint32_t* Candidates, uint32_t* Count, double Root, uint32_t MaxSteps)
+{
+	if (Root < -1.0 || Root > (double) MaxSteps + 1.0)
+		return;
+	int64_t Step = (int64_t) floor(Root), End = Step + 2;
+	for (; Step <= End; Step++)
+		if (Step >= 1 && Step <= MaxSteps && *Count < MAX_CANDIDATE_STEPS)
+			Candidates[(*Count)++] = (uint32_t) Step;
+}
+
+// Adds the steps at which the player's height crosses Height.
+static void AddPlayerYCandidateSteps(const struct GameState* State, uint32_t* Candidates, uint32_t* Count, fixed Height, uint32_t MaxSteps)
+{
+	// PlayerYAfter(k) = PlayerY + A k^2 + B k.
+	double A = State->Parameters.Gravity / 2.0,
+	       B = State->PlayerSpeed + State->Parameters.Gravity / 2.0,
+	       C = (double) State->PlayerY - Height;
+	double Discriminant = B * B - 4 * A * C;
+	if (Discriminant < 0.0)
+		return;
+	AddCandidateSteps(Candidates, Count, (-B - sqrt(Discriminant)) / (2 * A), MaxSteps);
+	AddCandidateSteps(Candidates, Count, (-B + sqrt(Discriminant)) / (2 * A), MaxSteps);
+}
+
+// Adds the steps at which an edge of a rectangle crosses X.
+static void AddEdgeXCandidateSteps(const struct GameState* State, uint32_t* Candidates, uint32_t* Count, fixed EdgeX, fixed X, uint32_t MaxSteps)
+{
+	AddCandidateSteps(Candidates, Count, ((double) X - EdgeX) / State->Parameters.FieldScroll, MaxSteps);
+}
+
+static bool IsOutsideField(fixed Y)
+{
+	return Y + COLLISION_B_HALF_HEIGHT > FIXED_FIELD_HEIGHT || Y - COLLISION_B_HALF_HEIGHT < 0;
+}
+
+// Returns the first step, among the next MaxSteps, at which the player leaves
+// the field; or 0 if the player stays in the field.
+static uint32_t StepsUntilBorderCollision(const struct GameState* State, uint32_t MaxSteps)
+{
+	uint32_t Candidates[MAX_CANDIDATE_STEPS], Count = 0, i, Result = 0;
+	Candidates[Count++] = 1;
+	AddPlayerYCandidateSteps(State, Candidates, &Count, FIXED_FIELD_HEIGHT - COLLISION_B_HALF_HEIGHT, MaxSteps);
+	AddPlayerYCandidateSteps(State, Candidates, &Count, COLLISION_B_HALF_HEIGHT, MaxSteps);
+	for (i = 0; i < Count; i++)
+		if ((Result == 0 || Candidates[i] < Result)
+		 && IsOutsideField(PlayerYAfter(State, Candidates[i])))
+			Result = Candidates[i];
+	return Result;
+}
+
+// Returns the first step, among the next MaxSteps, at which the player
+// collides with one of the 4 rectangles in the given group of slots; or 0 if
+// the player doesn't.
+static uint32_t StepsUntilRectangleCollision(const struct GameState* State, uint32_t Group, uint32_t MaxSteps)
+{
+	const struct Hitboxes* Hitboxes = &State->Rectangles.Hitboxes;
+	uint32_t Candidates[MAX_CANDIDATE_STEPS], Count = 0, Slot, i, Result = 0;
+	fixed PlayerX = State->PlayerX;
+	Candidates[Count++] = 1;
+	for (Slot = Group * 4; Slot < Group * 4 + 4; Slot++)
+	{
+		// If the rectangle's hitbox for A, the widest, never reaches the
+		// player horizontally, it can't start colliding with the player.
+		if (EdgeXAfter(State, Hitboxes->Left[0][Slot], MaxSteps) >= PlayerX
+		 || Hitboxes->Right[0][Slot] <= PlayerX)
+			continue;
+		for (i = 0; i < 2; i++)
+		{
+			AddEdgeXCandidateSteps(State, Candidates, &Count, Hitboxes->Left[i][Slot],  PlayerX, MaxSteps);
+			AddEdgeXCandidateSteps(State, Candidates, &Count, Hitboxes->Right[i][Slot], PlayerX, MaxSteps);
+			AddPlayerYCandidateSteps(State, Candidates, &Count, Hitboxes->Bottom[i][Slot], MaxSteps);
+			AddPlayerYCandidateSteps(State, Candidates, &Count, Hitboxes->Top[i][Slot],    MaxSteps);
+		}
+	}
+	// Nothing within reach?
+	if (Count == 1)
+		return 0;
+	for (i = 0; i < Count; i++)
+		if ((Result == 0 || Candidates[i] < Result)
+		 && CollideHitboxes4(PlayerX - (fixed) Candidates[i] * State->Parameters.FieldScroll,
+			PlayerYAfter(State, Candidates[i]), Hitboxes, Group * 4) != 0)
+			Result = Candidates[i];
+	return Result;
+}
+
+// Returns the first step, among the next MaxSteps, at which a pair of
+// rectangles needs to be generated; or 0 if none needs to be.
+static uint32_t StepsUntilGeneration(const struct GameState* State, uint32_t MaxSteps)
+{
+	if (State->RectangleCount == 0)
+		return 1;
+	// The first step k at which
+	// FIXED_FIELD_WIDTH - (LastRight + k * FieldScroll) >= GenDistance.
+	int64_t Distance = (int64_t) State->GenDistance - FIXED_FIELD_WIDTH
+		+ State->Rectangles.Right[RectangleSlot(State, State->RectangleCount - 1)];
+	int64_t Scroll = -State->Parameters.FieldScroll;
+	int64_t Step = Distance <= 0 ? 1 : (Distance + Scroll - 1) / Scroll;
+	if (Step < 1)
+		Step = 1;
+	return Step <= MaxSteps ? (uint32_t) Step : 0;
+}
+
+// Scrolls all rectangles to the left by Steps milliseconds' worth, awarding
+// points for those that went past the player and removing those that went
+// past the left side, as their field events come due.
+// Returns GAME_EVENT_PASS if points were awarded; otherwise 0.
+static uint32_t AdvanceRectangles(struct GameState* State, uint32_t Steps)
+{
+	struct HocoslamfyRects* Rectangles = &State->Rectangles;
+	struct Hitboxes* Hitboxes = &Rectangles->Hitboxes;
+	struct FieldEvent Event;
+	uint32_t Events = 0, i, j;
+	for (i = 0; i < State->RectangleCount; i++)
+	{
+		uint32_t Slot = RectangleSlot(State, i);
+		Rectangles->Left[Slot] = EdgeXAfter(State, Rectangles->Left[Slot], Steps);
+		Rectangles->Right[Slot] = EdgeXAfter(State, Rectangles->Right[Slot], Steps);
+		for (j = 0; j < 2; j++)
+		{
+			Hitboxes->Left[j][Slot] = EdgeXAfter(State, Hitboxes->Left[j][Slot], Steps);
+			Hitboxes->Right[j][Slot] = EdgeXAfter(State, Hitboxes->Right[j][Slot], Steps);
+		}
+	}
+	State->FieldTime += Steps;
+	while (State->RectangleCursor < State->RectangleCount
+	    && Hitboxes->Right[0][RectangleSlot(State, State->RectangleCursor)] <= State->PlayerX)
+		State->RectangleCursor += 2;
+	while (PopFieldEvent(&State->FieldEvents, State->FieldTime, &Event))
+	{
+		if (Event.Type == FIELD_EVENT_PASS)
+		{
+			// A column is past the player; award the player with a point.
+			Rectangles->Passed[Event.Slot] = Rectangles->Passed[Event.Slot + 1] = true;
+			State->Score++;
+			Events |= GAME_EVENT_PASS;
+		}
+		else
+		{
+			// The leftmost column is past the left side; remove it. It was
+			// already past the player, so the cursor is after it.
+			ClearRectangleSlot(State, RectangleSlot(State, 0));
+			ClearRectangleSlot(State, RectangleSlot(State, 1));
+			State->RectangleStart = (State->RectangleStart + 2) & (State->RectangleCapacity - 1);
+			State->RectangleCount -= 2;
+			State->RectangleCursor -= 2;
+		}
+	}
+	return Events;
+}
+
+static fixed NextGapTop(struct GameState* State)
+{
+	if (State->GapQueue == NULL)
+		return GenerateGapTop(&State->Gaps);
+	// The queue is filled long before it's needed, so this doesn't wait
+	// unless the thread filling it can't run at all.
+	while (!PopGap(State->GapQueue, &State->Gaps))
+		sched_yield();
+	return State->Gaps.GapTop;
+}
+
+static void GenerateRectangles(struct GameState* State)
+{
+	struct HocoslamfyRects* Rectangles = &State->Rectangles;
+	fixed Left;
+	if (State->RectangleCount == 0)
+		Left = FIXED_FIELD_WIDTH + State->Parameters.FieldScroll;
+	else
+	{
+		Left = Rectangles->Right[RectangleSlot(State, State->RectangleCount - 1)] + State->GenDistance;
+		State->GenDistance += State->Parameters.RectGenSpeed;
+		if (State->GenDistance < State->Parameters.RectGenMin)
+			State->GenDistance = State->Parameters.RectGenMin;
+	}
+	// InitializeGameState made room for this pair.
+	State->RectangleCount += 2;
+	uint32_t Top = RectangleSlot(State, State->RectangleCount - 2);
+	uint32_t Bottom = RectangleSlot(State, State->RectangleCount - 1);
+	Rectangles->Passed[Top] = Rectangles->Passed[Bottom] = false;
+	Rectangles->Left[Top] = Rectangles->Left[Bottom] = Left;
+	Rectangles->Right[Top] = Rectangles->Right[Bottom] = Left + FIXED_RECT_WIDTH;
+	// Where's the place for the player to go through?
+	fixed GapTop = NextGapTop(State);
+	Rectangles->Top[Top] = FIXED_FIELD_HEIGHT;
+	Rectangles->Bottom[Top] = GapTop;
+	Rectangles->Top[Bottom] = GapTop - State->Parameters.GapHeight;
+	Rectangles->Bottom[Bottom] = 0;
+	SetHitboxes(&Rectangles->Hitboxes, Top,
+		Rectangles->Left[Top], Rectangles->Top[Top], Rectangles->Right[Top], Rectangles->Bottom[Top]);
+	SetHitboxes(&Rectangles->Hitboxes, Bottom,
+		Rectangles->Left[Bottom], Rectangles->Top[Bottom], Rectangles->Right[Bottom], Rectangles->Bottom[Bottom]);
+	ScheduleFieldEvent(&State->FieldEvents,
+		State->FieldTime + StepsUntilLeftOf(Rectangles->Right[Top], State->PlayerX, State->Parameters.FieldScroll),
+		FIELD_EVENT_PASS, Top);
+	ScheduleFieldEvent(&State->FieldEvents,
+		State->FieldTime + StepsUntilLeftOf(Rectangles->Right[Top], 0, State->Parameters.FieldScroll),
+		FIELD_EVENT_REMOVE, Top);
+	Rectangles->Frame[Top] = RandomBelow(&State->Cosmetic, 3);
+	Rectangles->Frame[Bottom] = RandomBelow(&State->Cosmetic, 3);
+}
+
+// Moves the player by Steps milliseconds' worth of flight.
+static void AdvancePlayer(struct GameState* State, uint32_t Steps)
+{
+	State->PlayerY = PlayerYAfter(State, Steps);
+	State->PlayerSpeed += (fixed) Steps * State->Parameters.Gravity;
+}
+
+// Advances a live player by up to Milliseconds, stopping at the millisecond
+// at which the player collides with something.
+// Returns the GAME_EVENT_* bits of the things that happened, and updates
+// Milliseconds to the number of milliseconds that were not used.
+static uint32_t AdvanceAlive(struct GameState* State, uint32_t* Milliseconds)
+{
+	uint32_t Events = 0;
+	while (*Milliseconds > 0)
+	{
+		uint32_t Steps = *Milliseconds;
+		// Rectangles generated in the middle of the frame are at the right
+		// side of the field, far from the player. Stop at the millisecond
+		// they're generated so that the remainder of the frame includes them.
+		uint32_t GenerationStep = StepsUntilGeneration(State, Steps);
+		if (GenerationStep != 0)
+			Steps = GenerationStep;
+
+		// If the player's position has collided with the borders of the field
+		// or a rectangle, the player's game is over. At the same millisecond,
+		// the borders were checked first.
+		// Only the pairs of rectangles from the cursor onwards that come
+		// within reach of the player during these steps are tested, along
+		// with the others in their groups of 4 slots.
+		uint32_t CollisionStep = StepsUntilBorderCollision(State, Steps);
+		enum GameOverReason Reason = FIELD_BORDER_COLLISION;
+		uint32_t i, LastGroup = State->RectangleCapacity;
+		for (i = State->RectangleCursor; i < State->RectangleCount; i += 2)
+		{
+			uint32_t Limit = CollisionStep != 0 ? CollisionStep - 1 : Steps;
+			uint32_t Slot = RectangleSlot(State, i);
+			if (Limit == 0
+			 || EdgeXAfter(State, State->Rectangles.Hitboxes.Left[0][Slot], Limit) >= State->PlayerX)
+				break;
+			if (Slot / 4 == LastGroup)
+				continue;
+			LastGroup = Slot / 4;
+			uint32_t RectangleStep = StepsUntilRectangleCollision(State, LastGroup, Limit);
+			if (RectangleStep != 0)
+			{
+				CollisionStep = RectangleStep;
+				Reason = RECTANGLE_COLLISION;
+			}
+		}
+		if (CollisionStep != 0)
+			Steps = CollisionStep;
+
+		Events |= AdvanceRectangles(State, Steps);
+		if (Steps == GenerationStep)
+			GenerateRectangles(State);
+		AdvancePlayer(State, Steps);
+		*Milliseconds -= Steps;
+
+		if (CollisionStep != 0)
+		{
+			State->PlayerStatus = COLLIDED;
+			State->GameOverReason = Reason;
+			State->CollisionTime = 0;
+			Events |= GAME_EVENT_COLLIDE;
+			break;
+		}
+	}
+	return Events;
+}
+
+// Advances a dying player by up to Milliseconds, stopping at the millisecond
+// at which the player's position reaches the bottom of the field.
+// Returns the GAME_EVENT_* bits of the things that happened.
+static uint32_t AdvanceDying(struct GameState* State, uint32_t Milliseconds)
+{
+	uint32_t Candidates[MAX_CANDIDATE_STEPS], Count = 0, i, Steps = 0;
+	Candidates[Count++] = 1;
+	AddPlayerYCandidateSteps(State, Candidates, &Count, 0, Milliseconds);
+	for (i = 0; i < Count; i++)
+		if (Candidates[i] <= Milliseconds
+		 && (Steps == 0 || Candidates[i] < Steps)
+		 && PlayerYAfter(State, Candidates[i]) < 0)
+			Steps = Candidates[i];
+
+	if (Steps != 0)
+	{
+		AdvancePlayer(State, Steps);
+		State->PlayerStatus = DEAD;
+		State->Time -= Milliseconds - Steps;
+		return GAME_EVENT_DIE;
+	}
+	AdvancePlayer(State, Milliseconds);
+	return 0;
+}
+
+uint32_t AdvanceGameState(struct GameState* State, bool Boost, uint32_t Milliseconds)
+{
+	uint32_t Events = 0;
+
+	if (State->PlayerStatus != DEAD)
+		State->Time += Milliseconds;
+
+	if (State->PlayerStatus == ALIVE && Milliseconds > 0)
+	{
+		if (Boost)
+		{
+			// The player expects to rise a constant amount with each press of
+			// the triggering key or button, so set his or her speed to
+			// boost him or her from zero, even if the speed was positive.
+			// For a more physically-realistic version of thrust, use
+			// [PlayerSpeed += SpeedBoost;].
+			// Gravity is applied in the first millisecond, so compensate.
+			State->PlayerSpeed = State->Parameters.SpeedBoost - State->Parameters.Gravity;
+			Events |= GAME_EVENT_BOOST;
+		}
+		Events |= AdvanceAlive(State, &Milliseconds);
+	}
+
+	// The collision is shown for COLLISION_TIME milliseconds, then the player
+	// starts falling from where the collision happened.
+	if (State->PlayerStatus == COLLIDED && Milliseconds > 0)
+	{
+		uint32_t Steps = COLLISION_TIME - State->CollisionTime;
+		if (Steps > Milliseconds)
+			Steps = Milliseconds;
+		State->CollisionTime += Steps;
+		Milliseconds -= Steps;
+		if (State->CollisionTime >= COLLISION_TIME)
+		{
+			State->PlayerStatus = DYING;
+			State->PlayerSpeed = 0;
+		}
+	}
+
+	if (State->PlayerStatus == DYING && Milliseconds > 0)
+		Events |= AdvanceDying(State, Milliseconds);
+
+	return Events;
+}
+
+void ResetGameState(struct GameState* State, uint64_t Seed)
+{
+	uint32_t i;
+
+	State->Score = 0;
+	State->Time = 0;
+	State->PlayerStatus = ALIVE;
+	State->GameOverReason = FIELD_BORDER_COLLISION;
+	State->CollisionTime = 0;
+	State->PlayerX = FIXED_PLAYER_X;
+	State->PlayerY = FIXED_PLAYER_START_Y;
+	State->PlayerSpeed = 0;
+
+	for (i = 0; i < State->RectangleCapacity; i++)
+		ClearRectangleSlot(State, i);
+	State->RectangleStart = 0;
+	State->RectangleCount = 0;
+	State->RectangleCursor = 0;
+	State->GenDistance = State->Parameters.RectGenStart;
+	State->FieldTime = 0;
+	State->FieldEvents = (struct FieldEventQueue) { .Start = 0, .Count = 0 };
+
+	State->Seed = Seed;
+	InitializeGapGenerator(&State->Gaps, Seed, &State->Parameters);
+	State->GapQueue = NULL;
+	SeedRandom(&State->Cosmetic, Seed, RANDOM_STREAM_COSMETIC);
+}
+
+bool SetGameParameters(struct GameState* State, const struct GameParameters* Parameters)
+{
+	if (!CheckGameParameters(Parameters))
+		return false;
+	State->Parameters = *Parameters;
+	ResetGameState(State, State->Seed);
+	return true;
+}
+
+bool InitializeGameState(struct GameState* State, uint64_t Seed)
+{
+	uint32_t i;
+
+	// Check that RECTANGLE_CAPACITY is enough for this field.
+	if (!CheckGameParameters(&DefaultParameters))
+		return false;
+	State->Parameters = DefaultParameters;
+	State->RectangleCapacity = RECTANGLE_CAPACITY;
+	State->Rectangles.Left   = malloc(State->RectangleCapacity * sizeof(fixed));
+	State->Rectangles.Top    = malloc(State->RectangleCapacity * sizeof(fixed));
+	State->Rectangles.Right  = malloc(State->RectangleCapacity * sizeof(fixed));
+	State->Rectangles.Bottom = malloc(State->RectangleCapacity * sizeof(fixed));
+	State->Rectangles.Passed = malloc(State->RectangleCapacity * sizeof(bool));
+	State->Rectangles.Frame  = malloc(State->RectangleCapacity * sizeof(uint8_t));
+	// The 8 arrays of hitboxes are allocated together, from Left[0].
+	fixed* Hitboxes = malloc(8 * State->RectangleCapacity * sizeof(fixed));
+	State->Rectangles.Hitboxes = (struct Hitboxes) { { NULL } };
+	if (State->Rectangles.Left == NULL || State->Rectangles.Top == NULL
+	 || State->Rectangles.Right == NULL || State->Rectangles.Bottom == NULL
+	 || State->Rectangles.Passed == NULL || State->Rectangles.Frame == NULL
+	 || Hitboxes == NULL)
+	{
+		free(Hitboxes);
+		FinalizeGameState(State);
+		return false;
+	}
+	for (i = 0; i < 2; i++)
+	{
+		State->Rectangles.Hitboxes.Left[i]   = Hitboxes + (i * 4 + 0) * State->RectangleCapacity;
+		State->Rectangles.Hitboxes.Top[i]    = Hitboxes + (i * 4 + 1) * State->RectangleCapacity;
+		State->Rectangles.Hitboxes.Right[i]  = Hitboxes + (i * 4 + 2) * State->RectangleCapacity;
+		State->Rectangles.Hitboxes.Bottom[i] = Hitboxes + (i * 4 + 3) * State->RectangleCapacity;
+	}
+	ResetGameState(State, Seed);
+	return true;
+}
+
+void FinalizeGameState(struct GameState* State)
+{
+	free(State->Rectangles.Left);
+	free(State->Rectangles.Top);
+	free(State->Rectangles.Right);
+	free(State->Rectangles.Bottom);
+	free(State->Rectangles.Passed);
+	free(State->Rectangles.Frame);
+	free(State->Rectangles.Hitboxes.Left[0]);
+	State->Rectangles = (struct HocoslamfyRects) { NULL };
+	State->RectangleCapacity = 0;
+	State->RectangleCount = 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * Hocoslamfy, game simulation header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fixed.h"
+#include "rng.h"
+#include "gaps.h"
+#include "events.h"
+#include "params.h"
+#include "init.h"
+#include "game.h"
+#include "collision.h"
+
+// The simulation of a game, separate from its display, its sounds and its
+// input. It doesn't use SDL, and is also built as libhocosim.a for programs
+// that play many games without a screen.
+
+// The rectangles the player avoids, stored as one array per member so that
+// they can be tested for collisions 4 at a time (see collision.h).
+struct HocoslamfyRects
+{
+	fixed*   Left;
+	fixed*   Top;
+	fixed*   Right;
+	fixed*   Bottom;
+	bool*    Passed;
+	uint8_t* Frame;
+	// Set when a rectangle is generated, and scrolled along with it.
+	struct Hitboxes Hitboxes;
+};
+
+enum PlayerStatus
+{
+	ALIVE,
+	COLLIDED,
+	DYING,
+	DEAD
+};
+
+enum GameOverReason
+{
+	FIELD_BORDER_COLLISION,
+	RECTANGLE_COLLISION
+};
+
+// The number of rectangles a game has room for. It's enough for the worst case:
+// pairs of rectangles as close together as RECT_GEN_MIN allows across the
+// entire field, plus the pair leaving by the left side and the pair being
+// generated at the right side. It must be a power of 2, and at least 4,
+// because collision tests work on groups of 4 slots.
+#define RECTANGLE_CAPACITY 16
+
+// Things that happened during a call to AdvanceGameState, as a bitmask.
+#define GAME_EVENT_BOOST   0x01 /* The player's boost was applied. */
+#define GAME_EVENT_PASS    0x02 /* The player passed at least one column. */
+#define GAME_EVENT_COLLIDE 0x04 /* The player collided (see GameOverReason). */
+#define GAME_EVENT_DIE     0x08 /* The player fell to the bottom after dying. */
+
+struct GameState
+{
+	uint32_t               Score;
+	// The number of milliseconds the game has been played for, up to the
+	// millisecond the player died, so that it doesn't depend on how long the
+	// frames were.
+	uint32_t               Time;
+	enum PlayerStatus      PlayerStatus;
+	enum GameOverReason    GameOverReason;
+	// Time spent in the COLLIDED status. (In milliseconds.)
+	uint32_t               CollisionTime;
+
+	// Where the player is. (Center, fixed-point meters.)
+	fixed                  PlayerX;
+	fixed                  PlayerY;
+	// Where the player is going. (Fixed-point meters per millisecond.)
+	fixed                  PlayerSpeed;
+
+	// What the player avoids. This is a circular buffer, allocated once by
+	// InitializeGameState to hold as many rectangles as can be on the field
+	// at once, and indexed from RectangleStart. Rectangles are always added
+	// and removed in pairs, so even-numbered indices are at the top of the
+	// field and odd-numbered indices are at the bottom, as seen by
+	// RectangleSlot.
+	// Slots that don't hold a rectangle are emptied, so that collision tests
+	// can run on groups of 4 slots regardless of their contents.
+	struct HocoslamfyRects Rectangles;
+	uint32_t               RectangleCapacity;
+	uint32_t               RectangleStart;
+	uint32_t               RectangleCount;
+	// Index of the first rectangle whose Right is past the left of the
+	// player's collision rectangle A. Rectangles are sorted by X, so the ones
+	// before it can't collide with the player anymore.
+	uint32_t               RectangleCursor;
+
+	fixed                  GenDistance;
+
+	// The number of milliseconds the field has scrolled for, and the times,
+	// in those, at which the columns on it will go past the player and the
+	// left side (see events.h).
+	uint32_t               FieldTime;
+	struct FieldEventQueue FieldEvents;
+
+	// The parameters the game is played with (see params.h).
+	struct GameParameters  Parameters;
+
+	// The seed the game was started with, and the generators seeded from it
+	// (see rng.h and gaps.h).
+	uint64_t               Seed;
+	struct GapGenerator    Gaps;
+	struct Random          Cosmetic;
+	// If not NULL, the gaps of the columns are taken from this queue, which
+	// another thread fills with a generator seeded like Gaps, rather than
+	// generated by Gaps; Gaps is then kept as if it had generated them.
+	// ResetGameState and LoadGameState set it to NULL.
+	struct GapQueue*       GapQueue;
+};
+
+// Everything about a game that AdvanceGameState changes, in one structure
+// that has no pointers and can be copied around with memcpy. The rectangle
+// slots are stored from the leftmost rectangle's onward, and the field events
+// refer to them that way; their hitboxes are computed again from them when
+// the snapshot is loaded. The parameters of
+// the game aren't, so a snapshot must be loaded into a game with the same
+// parameters as the one it was saved from.
+struct GameSnapshot
+{
+	uint32_t               Score;
+	uint32_t               Time;
+	enum PlayerStatus      PlayerStatus;
+	enum GameOverReason    GameOverReason;
+	uint32_t               CollisionTime;
+	fixed                  PlayerX;
+	fixed                  PlayerY;
+	fixed                  PlayerSpeed;
+	uint32_t               RectangleCount;
+	uint32_t               RectangleCursor;
+	fixed                  GenDistance;
+	uint32_t               FieldTime;
+	struct FieldEventQueue FieldEvents;
+	uint64_t               Seed;
+	struct GapGenerator    Gaps;
+	struct Random          Cosmetic;
+	fixed                  Left[RECTANGLE_CAPACITY];
+	fixed                  Top[RECTANGLE_CAPACITY];
+	fixed                  Right[RECTANGLE_CAPACITY];
+	fixed                  Bottom[RECTANGLE_CAPACITY];
+	bool                   Passed[RECTANGLE_CAPACITY];
+	uint8_t                Frame[RECTANGLE_CAPACITY];
+};
+
+// Allocates the rectangle buffer of a game and starts the game with the given
+// seed and DefaultParameters. Returns false if memory could not be allocated.
+extern bool InitializeGameState(struct GameState* State, uint64_t Seed);
+
+// Frees the rectangle buffer of a game.
+extern void FinalizeGameState(struct GameState* State);
+
+// Starts a new game with the given seed, reusing the rectangle buffer and the
+// parameters of a game. Games started with the same seed and parameters and
+// given the same input play out the same way.
+extern void ResetGameState(struct GameState* State, uint64_t Seed);
+
+// Starts a new game with the same seed as a game, but the given parameters.
+// Returns false, leaving the game as it was, if CheckGameParameters rejects
+// them.
+extern bool SetGameParameters(struct GameState* State, const struct GameParameters* Parameters);
+
+// Advances a game by the given number of milliseconds. If Boost is true and
+// the player is alive, the player is boosted first.
+// Returns the GAME_EVENT_* bits of the things that happened.
+extern uint32_t AdvanceGameState(struct GameState* State, bool Boost, uint32_t Milliseconds);
+
+// Copies everything about a game that AdvanceGameState changes into a
+// snapshot.
+extern void SaveGameState(const struct GameState* State, struct GameSnapshot* Snapshot);
+
+// Puts a game back the way it was when a snapshot was saved from it, or from
+// another game. Playing it from there with the same input gives the same
+// results as it did from the snapshot.
+// The game's gaps are then generated by State->Gaps, since those in
+// State->GapQueue may be later ones.
+extern void LoadGameState(struct GameState* State, const struct GameSnapshot* Snapshot);
+
+// Returns the slot in State->Rectangles of the Index-th rectangle on the field,
+// from left to right.
+extern uint32_t RectangleSlot(const struct GameState* State, uint32_t Index);
+
+#endif /* !defined(_SIM_H_) */
@@ -0,0 +1,53 @@
+/*
+ * Hocoslamfy, game snapshot header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sim.h"
+#include "bg.h"
+
+// Everything about the game being played, including how it's shown, in one
+// structure that has no pointers and can be copied around with memcpy.
+struct RunSnapshot
+{
+	struct GameSnapshot Game;
+	float               BackgroundX[BG_LAYER_COUNT];
+	uint8_t             PlayerFrame;
+	bool                PlayerBlinking;
+	uint32_t            PlayerFrameTime;
+	uint32_t            PlayerBlinkTime;
+	fixed               PreviousPlayerY;
+	fixed               PreviousScroll;
+	// The number of boosts recorded for the game's replay, or the index of
+	// the next boost of the replay being played.
+	uint32_t            BoostCount;
+};
+
+// Copies the game being played into a snapshot.
+extern void SaveRun(struct RunSnapshot* Snapshot);
+
+// Puts the game being played back the way it was when a snapshot was saved
+// from it. Boosts recorded after that are forgotten.
+extern void LoadRun(const struct RunSnapshot* Snapshot);
+
+#endif /* !defined(_SNAPSHOT_H_) */
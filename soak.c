@@ -0,0 +1,165 @@
+/*
+ * Hocoslamfy, soak test code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/time.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "soak.h"
+
+struct SoakPeriod
+{
+	uint64_t Frames;
+	uint64_t Games;
+	uint64_t TotalScore;
+	// Microseconds spent on frames, and on the longest one.
+	uint64_t FrameTime;
+	uint64_t MaxFrameTime;
+};
+
+static uint64_t          StartTime;
+static uint64_t          EndTime;
+static uint64_t          LastFrameEnd;
+static uint64_t          NextReport;
+
+static struct SoakPeriod Period;
+static struct SoakPeriod Total;
+
+// Memory use in the first report, to compare the following ones to.
+static uint64_t          FirstRSS;
+static uint64_t          FirstHeap;
+
+static uint64_t Microseconds(void)
+{
+	struct timeval Now;
+	gettimeofday(&Now, NULL);
+	return (uint64_t) Now.tv_sec * 1000000 + Now.tv_usec;
+}
+
+// Returns the number of bytes of memory the program has in RAM, or 0 if that
+// can't be known here.
+static uint64_t GetRSS(void)
+{
+	unsigned long Size, Resident;
+	uint64_t Result = 0;
+	FILE* fp = fopen("/proc/self/statm", "r");
+	if (fp)
+	{
+		if (fscanf(fp, "%lu %lu", &Size, &Resident) == 2)
+			Result = (uint64_t) Resident * sysconf(_SC_PAGESIZE);
+		fclose(fp);
+	}
+	return Result;
+}
+
+// Returns the number of bytes allocated with malloc and not yet freed, or 0
+// if that can't be known here.
+static uint64_t GetHeapInUse(void)
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+	struct mallinfo2 Info = mallinfo2();
+	return (uint64_t) Info.uordblks + (uint64_t) Info.hblkhd;
+#elif defined(__GLIBC__)
+	struct mallinfo Info = mallinfo();
+	return (uint64_t) (unsigned int) Info.uordblks + (uint64_t) (unsigned int) Info.hblkhd;
+#else
+	return 0;
+#endif
+}
+
+static void AddPeriod(struct SoakPeriod* To, const struct SoakPeriod* From)
+{
+	To->Frames += From->Frames;
+	To->Games += From->Games;
+	To->TotalScore += From->TotalScore;
+	To->FrameTime += From->FrameTime;
+	if (From->MaxFrameTime > To->MaxFrameTime)
+		To->MaxFrameTime = From->MaxFrameTime;
+}
+
+static void Report(const char* Label, const struct SoakPeriod* What, uint64_t Now)
+{
+	uint64_t RSS = GetRSS(), Heap = GetHeapInUse();
+	if (FirstRSS == 0 && FirstHeap == 0)
+	{
+		FirstRSS = RSS;
+		FirstHeap = Heap;
+	}
+
+	printf("Soak %s %" PRIu64 " s: %" PRIu64 " frames, frame time mean %.3f ms, max %.3f ms; %" PRIu64 " games, mean score %.2f; RSS %" PRIu64 " KiB (%+" PRId64 "), heap %" PRIu64 " KiB (%+" PRId64 ")\n",
+		Label, (Now - StartTime) / 1000000, What->Frames,
+		What->Frames ? What->FrameTime / 1000.0 / What->Frames : 0.0,
+		What->MaxFrameTime / 1000.0,
+		What->Games,
+		What->Games ? (double) What->TotalScore / What->Games : 0.0,
+		RSS / 1024, ((int64_t) RSS - (int64_t) FirstRSS) / 1024,
+		Heap / 1024, ((int64_t) Heap - (int64_t) FirstHeap) / 1024);
+	fflush(stdout);
+}
+
+void StartSoak(uint32_t Seconds)
+{
+	StartTime = LastFrameEnd = Microseconds();
+	EndTime = StartTime + (uint64_t) Seconds * 1000000;
+	NextReport = StartTime + (uint64_t) SOAK_REPORT_INTERVAL * 1000000;
+	Period = (struct SoakPeriod) { 0 };
+	Total = (struct SoakPeriod) { 0 };
+	FirstRSS = FirstHeap = 0;
+}
+
+void SoakFrame(bool* Continue)
+{
+	uint64_t Now = Microseconds(), FrameTime = Now - LastFrameEnd;
+	LastFrameEnd = Now;
+
+	Period.Frames++;
+	Period.FrameTime += FrameTime;
+	if (FrameTime > Period.MaxFrameTime)
+		Period.MaxFrameTime = FrameTime;
+
+	if (Now >= NextReport)
+	{
+		Report("at", &Period, Now);
+		AddPeriod(&Total, &Period);
+		Period = (struct SoakPeriod) { 0 };
+		NextReport += (uint64_t) SOAK_REPORT_INTERVAL * 1000000;
+	}
+	if (Now >= EndTime)
+		*Continue = false;
+}
+
+void SoakGameOver(uint32_t Score)
+{
+	Period.Games++;
+	Period.TotalScore += Score;
+}
+
+void FinishSoak(void)
+{
+	AddPeriod(&Total, &Period);
+	Period = (struct SoakPeriod) { 0 };
+	Report("done after", &Total, Microseconds());
+}
@@ -0,0 +1,48 @@
+/*
+ * Hocoslamfy, soak test header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _SOAK_H_
+#define _SOAK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A soak test plays games unattended with the autopilot, one after the
+// other, as fast as frames can be drawn, for a given number of seconds of
+// real time. Every SOAK_REPORT_INTERVAL seconds, it reports how long frames
+// took and how much memory the program uses, so that slowdowns and leaks
+// show up long before a build is left running for days.
+
+#define SOAK_REPORT_INTERVAL 60
+
+// The number of milliseconds of game time played in each frame.
+#define SOAK_FRAME_DURATION  16
+
+extern void StartSoak(uint32_t Seconds);
+
+// To be called after each frame is drawn. Sets *Continue to false once the
+// soak test has run for long enough.
+extern void SoakFrame(bool* Continue);
+
+extern void SoakGameOver(uint32_t Score);
+
+// Reports the whole soak test.
+extern void FinishSoak(void);
+
+#endif /* !defined(_SOAK_H_) */
@@ -0,0 +1,152 @@
+/*
+ * Hocoslamfy, span image code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "span.h"
+#include "blend.h"
+
+static bool MakeSpans(struct SpanImage* Image)
+{
+	uint32_t Count = 0, Capacity = 0;
+	int x, y;
+
+	for (y = 0; y < Image->Height; y++)
+	{
+		const uint32_t* Row = &Image->Pixels[y * Image->Width];
+		Image->RowStart[y] = Count;
+		x = 0;
+		while (x < Image->Width)
+		{
+			uint32_t Alpha = Row[x] >> 24;
+			if (Alpha == 0)
+			{
+				x++;
+				continue;
+			}
+			if (Count == Capacity)
+			{
+				struct Span* Spans;
+				Capacity = Capacity ? Capacity * 2 : 256;
+				if ((Spans = realloc(Image->Spans, Capacity * sizeof(struct Span))) == NULL)
+					return false;
+				Image->Spans = Spans;
+			}
+			struct Span* Span = &Image->Spans[Count++];
+			Span->X = x;
+			Span->Opaque = Alpha == 0xFF;
+			while (x < Image->Width && (Row[x] >> 24) != 0
+			    && ((Row[x] >> 24) == 0xFF) == Span->Opaque)
+				x++;
+			Span->Length = x - Span->X;
+		}
+	}
+	Image->RowStart[Image->Height] = Count;
+	return true;
+}
+
+bool MakeSpanImage(struct SpanImage* Image, const uint32_t* Pixels, int Width, int Height, int Pitch)
+{
+	int y;
+
+	memset(Image, 0, sizeof(struct SpanImage));
+	Image->Width = Width;
+	Image->Height = Height;
+	Image->Pixels = malloc(Width * Height * sizeof(uint32_t));
+	Image->RowStart = malloc((Height + 1) * sizeof(uint32_t));
+	if (Image->Pixels == NULL || Image->RowStart == NULL)
+	{
+		FreeSpanImage(Image);
+		return false;
+	}
+	for (y = 0; y < Height; y++)
+		memcpy(&Image->Pixels[y * Width], (const uint8_t*) Pixels + y * Pitch, Width * sizeof(uint32_t));
+	if (!MakeSpans(Image))
+	{
+		FreeSpanImage(Image);
+		return false;
+	}
+	PremultiplyPixels(Image->Pixels, Width * Height);
+	return true;
+}
+
+void FreeSpanImage(struct SpanImage* Image)
+{
+	free(Image->Pixels);
+	free(Image->Spans);
+	free(Image->RowStart);
+	memset(Image, 0, sizeof(struct SpanImage));
+}
+
+void BlitSpanImage(const struct SpanImage* Image, const struct SpanRect* Source, uint32_t* Dest, int Pitch, int DestX, int DestY, const struct SpanRect* Clip)
+{
+	int SourceX = Source->X, SourceY = Source->Y,
+	    Width = Source->Width, Height = Source->Height, y;
+
+	// Clip the source to the image, then the destination to the clipping
+	// rectangle, as SDL does.
+	if (SourceX < 0)
+	{
+		Width += SourceX;  DestX -= SourceX;  SourceX = 0;
+	}
+	if (SourceX + Width > Image->Width)
+		Width = Image->Width - SourceX;
+	if (SourceY < 0)
+	{
+		Height += SourceY;  DestY -= SourceY;  SourceY = 0;
+	}
+	if (SourceY + Height > Image->Height)
+		Height = Image->Height - SourceY;
+	if (DestX < Clip->X)
+	{
+		Width -= Clip->X - DestX;  SourceX += Clip->X - DestX;  DestX = Clip->X;
+	}
+	if (DestX + Width > Clip->X + Clip->Width)
+		Width = Clip->X + Clip->Width - DestX;
+	if (DestY < Clip->Y)
+	{
+		Height -= Clip->Y - DestY;  SourceY += Clip->Y - DestY;  DestY = Clip->Y;
+	}
+	if (DestY + Height > Clip->Y + Clip->Height)
+		Height = Clip->Y + Clip->Height - DestY;
+	if (Width <= 0 || Height <= 0)
+		return;
+
+	for (y = 0; y < Height; y++)
+	{
+		const uint32_t* SourceRow = &Image->Pixels[(SourceY + y) * Image->Width];
+		uint32_t* DestRow = (uint32_t*) ((uint8_t*) Dest + (DestY + y) * Pitch) + DestX;
+		const struct Span* Span = &Image->Spans[Image->RowStart[SourceY + y]];
+		const struct Span* End = &Image->Spans[Image->RowStart[SourceY + y + 1]];
+		for (; Span < End && Span->X < SourceX + Width; Span++)
+		{
+			int Start = Span->X > SourceX ? Span->X : SourceX,
+			    Stop = Span->X + Span->Length < SourceX + Width ? Span->X + Span->Length : SourceX + Width;
+			if (Stop <= Start)
+				continue;
+			if (Span->Opaque)
+				memcpy(&DestRow[Start - SourceX], &SourceRow[Start], (Stop - Start) * sizeof(uint32_t));
+			else
+				BlendPixels(&DestRow[Start - SourceX], &SourceRow[Start], Stop - Start);
+		}
+	}
+}
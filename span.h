@@ -0,0 +1,71 @@
+/*
+ * Hocoslamfy, span image header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _SPAN_H_
+#define _SPAN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A span image holds 32-bit pixels with alpha in the top byte as lists of
+// spans of pixels per row: opaque spans, which are copied, and partly
+// transparent ones, which are blended by BlendPixels (see blend.h). Fully
+// transparent pixels are in no span, and are skipped. Span sprites (see
+// sprite.h) blit their images through these; they don't use SDL, so that a
+// tool can check them.
+
+struct Span
+{
+	uint16_t X;
+	uint16_t Length;
+	bool     Opaque;
+};
+
+struct SpanImage
+{
+	int          Width;
+	int          Height;
+	// The pixels of the image, Width per row, premultiplied by alpha.
+	uint32_t*    Pixels;
+	// The spans of row y are Spans[RowStart[y]] to Spans[RowStart[y + 1] - 1],
+	// from left to right.
+	struct Span* Spans;
+	uint32_t*    RowStart;
+};
+
+struct SpanRect
+{
+	int X;
+	int Y;
+	int Width;
+	int Height;
+};
+
+// Copies Width x Height pixels, Pitch bytes apart per row, into Image and
+// splits them into spans. Returns false if memory runs out, leaving nothing
+// to free.
+extern bool MakeSpanImage(struct SpanImage* Image, const uint32_t* Pixels, int Width, int Height, int Pitch);
+extern void FreeSpanImage(struct SpanImage* Image);
+
+// Blits the Source rectangle of Image to (DestX, DestY) in Dest, which has
+// Pitch bytes per row, the way SDL_BlitSurface does: Source is clipped to
+// the image, then the destination to Clip, which must be within Dest.
+extern void BlitSpanImage(const struct SpanImage* Image, const struct SpanRect* Source, uint32_t* Dest, int Pitch, int DestX, int DestY, const struct SpanRect* Clip);
+
+#endif /* !defined(_SPAN_H_) */
@@ -0,0 +1,103 @@
+/*
+ * Hocoslamfy, span sprite code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include "SDL.h"
+
+#include "main.h"
+#include "sprite.h"
+
+// Whether spans can be made from pixels of an image and written to a
+// surface: both must be 32 bits per pixel, with the same red, green and blue
+// bytes, and alpha in the top byte of the image.
+static bool CanUseSpans(const SDL_PixelFormat* Image, const SDL_PixelFormat* Dest)
+{
+	return Image->BitsPerPixel == 32 && Dest->BitsPerPixel == 32
+	    && Image->Amask == 0xFF000000
+	    && (Image->Rmask | Image->Gmask | Image->Bmask) == 0x00FFFFFF
+	    && Image->Rmask == Dest->Rmask && Image->Gmask == Dest->Gmask && Image->Bmask == Dest->Bmask;
+}
+
+struct SpanSprite* CreateSpanSprite(SDL_Surface* Image, const char* Name)
+{
+	struct SpanSprite* Sprite = calloc(1, sizeof(struct SpanSprite));
+	bool Result;
+
+	if (Sprite == NULL)
+	{
+		printf("%s: CreateSpanSprite failed: out of memory\n", Name);
+		return NULL;
+	}
+	Sprite->Image = Image;
+	if (!CanUseSpans(Image->format, Screen->format))
+	{
+		printf("%s: not split into spans; it will be blitted by SDL\n", Name);
+		return Sprite;
+	}
+
+	// The pixels are copied, because SDL may free those of a surface that it
+	// run-length encodes.
+	if (SDL_MUSTLOCK(Image))
+		SDL_LockSurface(Image);
+	Result = MakeSpanImage(&Sprite->Spans, (const uint32_t*) Image->pixels, Image->w, Image->h, Image->pitch);
+	if (SDL_MUSTLOCK(Image))
+		SDL_UnlockSurface(Image);
+	if (!Result)
+	{
+		printf("%s: CreateSpanSprite failed: out of memory\n", Name);
+		FreeSpanSprite(Sprite);
+		return NULL;
+	}
+	printf("Split %s into %" PRIu32 " spans\n", Name, Sprite->Spans.RowStart[Sprite->Spans.Height]);
+	return Sprite;
+}
+
+void FreeSpanSprite(struct SpanSprite* Sprite)
+{
+	if (Sprite == NULL)
+		return;
+	FreeSpanImage(&Sprite->Spans);
+	free(Sprite);
+}
+
+void BlitSpanSprite(const struct SpanSprite* Sprite, const SDL_Rect* SourceRect, SDL_Surface* Dest, const SDL_Rect* DestRect)
+{
+	if (Sprite->Spans.Pixels == NULL)
+	{
+		SDL_Rect Source = *SourceRect, Target = *DestRect;
+		SDL_BlitSurface(Sprite->Image, &Source, Dest, &Target);
+		return;
+	}
+
+	struct SpanRect Source = { SourceRect->x, SourceRect->y, SourceRect->w, SourceRect->h },
+	                Clip = { Dest->clip_rect.x, Dest->clip_rect.y, Dest->clip_rect.w, Dest->clip_rect.h };
+
+	if (SDL_MUSTLOCK(Dest))
+		SDL_LockSurface(Dest);
+	BlitSpanImage(&Sprite->Spans, &Source, (uint32_t*) Dest->pixels, Dest->pitch, DestRect->x, DestRect->y, &Clip);
+	if (SDL_MUSTLOCK(Dest))
+		SDL_UnlockSurface(Dest);
+}
@@ -0,0 +1,54 @@
+/*
+ * Hocoslamfy, span sprite header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _SPRITE_H_
+#define _SPRITE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "SDL.h"
+
+#include "span.h"
+
+// A span sprite blits an image with alpha from a span image (see span.h),
+// which makes blits of sprites whose pixels are mostly either fully
+// transparent or opaque, with a few soft edges, cheaper than SDL's per-pixel
+// alpha blits. Blends are within 1 of SDL 1.2's.
+
+struct SpanSprite
+{
+	// The image the sprite was made from. If it couldn't be split into spans
+	// for the screen's pixel format, blits of the sprite blit it instead.
+	SDL_Surface*     Image;
+	// A copy of the image's pixels, split into spans; its Pixels are NULL if
+	// the image couldn't be.
+	struct SpanImage Spans;
+};
+
+// Makes a span sprite from an image already in the screen's pixel format.
+// Returns NULL and prints why if memory runs out.
+extern struct SpanSprite* CreateSpanSprite(SDL_Surface* Image, const char* Name);
+extern void FreeSpanSprite(struct SpanSprite* Sprite);
+
+// Like SDL_BlitSurface, including clipping to the clipping rectangle of Dest,
+// but doesn't change DestRect.
+extern void BlitSpanSprite(const struct SpanSprite* Sprite, const SDL_Rect* SourceRect, SDL_Surface* Dest, const SDL_Rect* DestRect);
+
+#endif /* !defined(_SPRITE_H_) */
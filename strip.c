@@ -0,0 +1,75 @@
+/*
+ * Hocoslamfy, background strip code file
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "strip.h"
+
+const uint32_t BG_StartY[BG_LAYER_COUNT] = {
+	/* "Sky.png", "Mountains.png", "Clouds3.png", "Clouds2.png",
+	 * "Clouds1.png", "Grass3.png", "Grass2.png", "Grass1.png" */
+	 50, 128,  32,  16,
+	  0, 180, 190, 204
+};
+const uint32_t BG_Height[BG_LAYER_COUNT] = {
+	140,  60,  28,  28,
+	 32,  20,  28,  36
+};
+
+uint32_t CutBackground(const bool Opaque[BG_LAYER_COUNT][SCREEN_HEIGHT], struct LayerStrip Strips[MAX_BG_STRIPS])
+{
+	// The last layer with an opaque row on each row of the screen, plus 1.
+	uint32_t TopOpaque[SCREEN_HEIGHT] = { 0 };
+	uint32_t Count = 0, i, y, Start;
+
+	for (i = 0; i < BG_LAYER_COUNT; i++)
+		for (y = 0; y < BG_Height[i] && BG_StartY[i] + y < SCREEN_HEIGHT; y++)
+			if (Opaque[i][y])
+				TopOpaque[BG_StartY[i] + y] = i + 1;
+
+	for (i = 0; i < BG_LAYER_COUNT; i++)
+	{
+		// Cut the visible rows of the layer into runs that are all opaque or
+		// all not.
+		y = 0;
+		while (y < BG_Height[i] && BG_StartY[i] + y < SCREEN_HEIGHT)
+		{
+			if (TopOpaque[BG_StartY[i] + y] > i + 1)
+			{
+				y++;
+				continue;
+			}
+			Start = y;
+			while (y < BG_Height[i] && BG_StartY[i] + y < SCREEN_HEIGHT
+			    && TopOpaque[BG_StartY[i] + y] <= i + 1
+			    && Opaque[i][y] == Opaque[i][Start])
+				y++;
+			if (Count == MAX_BG_STRIPS)
+				return MAX_BG_STRIPS + 1;
+			Strips[Count].Layer = i;
+			Strips[Count].SourceY = Start;
+			Strips[Count].Opaque = Opaque[i][Start];
+			Strips[Count].StartY = BG_StartY[i] + Start;
+			Strips[Count].Height = y - Start;
+			Count++;
+		}
+	}
+	return Count;
+}
@@ -0,0 +1,58 @@
+/*
+ * Hocoslamfy, background strip header
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _STRIP_H_
+#define _STRIP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "init.h"
+#include "bg.h"
+
+// The background is drawn in strips of rows of its layers. Rows that are
+// hidden behind opaque rows of a later layer aren't drawn at all, and rows
+// that are opaque across the whole image are copied, which is faster than
+// blending them. The strips are cut here without SDL, so that a tool can
+// check them.
+#define MAX_BG_STRIPS  32
+
+// The Y coordinates at which the various layers of the background start, and
+// their heights, on the screen. (In pixels of the screen.)
+extern const uint32_t BG_StartY[BG_LAYER_COUNT];
+extern const uint32_t BG_Height[BG_LAYER_COUNT];
+
+struct LayerStrip
+{
+	// The layer whose rows these are, and the first of them in its image.
+	uint32_t Layer;
+	uint32_t SourceY;
+	// Whether the rows have no transparency at all.
+	bool     Opaque;
+	// Where the rows are on the screen. (In pixels of the screen.)
+	uint32_t StartY;
+	uint32_t Height;
+};
+
+// Cuts the rows of the layers that are on the screen into strips, given
+// whether row y of layer i is opaque in Opaque[i][y]. Returns the number of
+// strips written to Strips, or MAX_BG_STRIPS + 1 if there would be more.
+extern uint32_t CutBackground(const bool Opaque[BG_LAYER_COUNT][SCREEN_HEIGHT], struct LayerStrip Strips[MAX_BG_STRIPS]);
+
+#endif /* !defined(_STRIP_H_) */
@@ -19,7 +19,10 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
 
 #include "SDL.h"
 #include "SDL_image.h"
@@ -30,14 +33,18 @@
 #include "game.h"
 #include "title.h"
 #include "bg.h"
+#include "dirty.h"
 #include "text.h"
 
 static bool     WaitingForRelease = false;
 static char*    WelcomeMessage    = NULL;
+static char     SeedMessage[64]   = "";
 
 static uint32_t HeaderFrame       = 0;
 static Uint32   HeaderFrameTime   = 0;
 
+static struct ScreenSprite HeaderSprite, MessageSprite;
+
 static const uint32_t HeaderFrameAnimation[TITLE_ANIMATION_FRAMES] = {
 	0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, /* up */
 	0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1,
@@ -105,24 +112,20 @@ void TitleScreenDoLogic(bool* Continue, bool* Error, Uint32 Milliseconds)
 	AdvanceBackground(Milliseconds);
 }
 
-void TitleScreenOutputFrame()
+static void DrawTitleScreen(const SDL_Rect* HeaderDestRect, const SDL_Rect* MessageRect, const SDL_Rect* Clip)
 {
 	DrawBackground();
 
-	SDL_Rect HeaderDestRect = {
-		.x = (SCREEN_WIDTH - TitleScreenFrames[0]->w) / 2,
-		.y = ((SCREEN_HEIGHT / 4) - TitleScreenFrames[0]->h) / 2,
-		.w = TitleScreenFrames[0]->w,
-		.h = TitleScreenFrames[0]->h
-	};
 	SDL_Rect HeaderSourceRect = {
 		.x = 0,
 		.y = 0,
 		.w = TitleScreenFrames[0]->w,
 		.h = TitleScreenFrames[0]->h
 	};
-	SDL_BlitSurface(TitleScreenFrames[HeaderFrameAnimation[HeaderFrame]], &HeaderSourceRect, Screen, &HeaderDestRect);
+	BlitSpanSprite(TitleScreenSprites[HeaderFrameAnimation[HeaderFrame]], &HeaderSourceRect, Screen, HeaderDestRect);
 
+	if (!IsTextBoxIn(MessageRect, Clip))
+		return;
 	if (SDL_MUSTLOCK(Screen))
 		SDL_LockSurface(Screen);
 	PrintStringOutline32(WelcomeMessage,
@@ -130,16 +133,58 @@ void TitleScreenOutputFrame()
 		SDL_MapRGB(Screen->format, 0, 0, 0),
 		Screen->pixels,
 		Screen->pitch,
-		0,
-		SCREEN_HEIGHT / 4,
-		SCREEN_WIDTH,
-		SCREEN_HEIGHT - (SCREEN_HEIGHT / 4),
+		MessageRect->x,
+		MessageRect->y,
+		MessageRect->w,
+		MessageRect->h,
 		CENTER,
 		MIDDLE);
 	if (SDL_MUSTLOCK(Screen))
 		SDL_UnlockSurface(Screen);
+}
+
+void TitleScreenOutputFrame()
+{
+	SDL_Rect HeaderDestRect = {
+		.x = (SCREEN_WIDTH - TitleScreenFrames[0]->w) / 2,
+		.y = ((SCREEN_HEIGHT / 4) - TitleScreenFrames[0]->h) / 2,
+		.w = TitleScreenFrames[0]->w,
+		.h = TitleScreenFrames[0]->h
+	};
+	SDL_Rect MessageRect = {
+		.x = 0,
+		.y = SCREEN_HEIGHT / 4,
+		.w = SCREEN_WIDTH,
+		.h = SCREEN_HEIGHT - (SCREEN_HEIGHT / 4)
+	};
+	FitTextBox(&MessageRect, WelcomeMessage);
+	const SDL_Rect* Rects;
+	uint32_t Count, i;
+
+	UpdateBackgroundSprites();
+	UpdateSprite(&HeaderSprite, &HeaderDestRect, HeaderFrameAnimation[HeaderFrame]);
+	// The message only changes while the title screen isn't shown.
+	UpdateTextSprite(&MessageSprite, &MessageRect, 0);
 
-	SDL_Flip(Screen);
+	Count = GetDirtyRects(&Rects);
+	for (i = 0; i < Count; i++)
+	{
+		SDL_SetClipRect(Screen, &Rects[i]);
+		DrawTitleScreen(&HeaderDestRect, &MessageRect, &Rects[i]);
+	}
+	SDL_SetClipRect(Screen, NULL);
+	PresentFrame();
+}
+
+void SetTitleSeedRating(const struct SeedRating* Rating)
+{
+	snprintf(SeedMessage, sizeof(SeedMessage), "Seed %" PRIu64 ": harder than %u%%\nof the seeds in the catalog\n\n",
+		Rating->Seed, (unsigned int) Rating->Difficulty);
+	if (WelcomeMessage != NULL)
+	{
+		free(WelcomeMessage);
+		WelcomeMessage = NULL;
+	}
 }
 
 void ToTitleScreen(void)
@@ -148,13 +193,14 @@ void ToTitleScreen(void)
 	{
 		int Length = 2, NewLength;
 		WelcomeMessage = malloc(Length);
-		while ((NewLength = snprintf(WelcomeMessage, Length, "Press %s to play\nor %s to exit\n\nIn-game:\n%s to rise\n%s to pause\n%s to exit", GetEnterGamePrompt(), GetExitGamePrompt(), GetBoostPrompt(), GetPausePrompt(), GetExitGamePrompt())) >= Length)
+		while ((NewLength = snprintf(WelcomeMessage, Length, "%sPress %s to play\nor %s to exit\n\nIn-game:\n%s to rise\n%s to pause\n%s%s%s%s to exit", SeedMessage, GetEnterGamePrompt(), GetExitGamePrompt(), GetBoostPrompt(), GetPausePrompt(), IsPracticeMode() ? "Hold " : "", IsPracticeMode() ? GetRewindPrompt() : "", IsPracticeMode() ? " to rewind\n" : "", GetExitGamePrompt())) >= Length)
 		{
 			Length = NewLength + 1;
 			WelcomeMessage = realloc(WelcomeMessage, Length);
 		}
 	}
 
+	InvalidateScreen();
 	GatherInput = TitleScreenGatherInput;
 	DoLogic     = TitleScreenDoLogic;
 	OutputFrame = TitleScreenOutputFrame;
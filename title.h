@@ -22,10 +22,16 @@
 
 #include <stdbool.h>
 
+#include "catalog.h"
+
 #define TITLE_FRAME_TIME        50
 #define TITLE_FRAME_COUNT        8
 #define TITLE_ANIMATION_FRAMES 144
 
 extern void ToTitleScreen(void);
 
+// Shows how hard the seed all games are played with is (see SetGameSeed) on
+// the title screen.
+extern void SetTitleSeedRating(const struct SeedRating* Rating);
+
 #endif /* !defined(_TITLE_H_) */
@@ -0,0 +1,88 @@
+/*
+ * Hocoslamfy, batch simulation tool
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// Plays a batch of games with BatchAutopilotController and reports how fast
+// they were played and how well the bot did.
+// Usage: hocobatch [games [seconds [threads [seed]]]]
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <time.h>
+
+#include "sim.h"
+#include "batch.h"
+#include "args.h"
+
+int main(int argc, char* argv[])
+{
+	uint32_t Games   = 100000;
+	uint32_t Seconds = 120;
+	uint32_t Threads = 0;
+	uint64_t Seed    = 1;
+	struct GameBatch Batch;
+	struct timespec Start, End;
+	uint32_t i;
+
+	if (argc > 5
+	 || (argc > 1 && !ParseUint32(argv[1], 1, &Games))
+	 || (argc > 2 && !ParseUint32(argv[2], 1, &Seconds))
+	 || (argc > 3 && !ParseUint32(argv[3], 0, &Threads))
+	 || (argc > 4 && !ParseUint64(argv[4], &Seed)))
+	{
+		fprintf(stderr, "Usage: %s [games [seconds [threads [seed]]]]\n", argv[0]);
+		return 2;
+	}
+	if (!InitializeGameBatch(&Batch, Games, Seconds * 1000, Seed, &DefaultParameters))
+	{
+		printf("Failed to allocate a batch of %" PRIu32 " games\n", Games);
+		return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	Threads = RunGameBatch(&Batch, Threads, BatchAutopilotController, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	double Elapsed = (End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec) / 1e9;
+
+	uint64_t TotalTime = 0, TotalScore = 0;
+	uint32_t MaxScore = 0, Borders = 0, Unfinished = 0;
+	for (i = 0; i < Batch.Count; i++)
+	{
+		TotalTime += Batch.Time[i];
+		TotalScore += Batch.Score[i];
+		if (Batch.Score[i] > MaxScore)
+			MaxScore = Batch.Score[i];
+		if (Batch.Playing[i])
+			Unfinished++;
+		else if (Batch.GameOverReason[i] == FIELD_BORDER_COLLISION)
+			Borders++;
+	}
+
+	printf("%" PRIu32 " games on %" PRIu32 " threads in %.3f s: %.0f games/s, %.1f million milliseconds/s\n",
+		Batch.Count, Threads, Elapsed, Batch.Count / Elapsed, TotalTime / Elapsed / 1e6);
+	printf("Score: mean %.2f, max %" PRIu32 "\n", Batch.Count ? (double) TotalScore / Batch.Count : 0.0, MaxScore);
+	printf("Game over: %" PRIu32 " by the border, %" PRIu32 " by a column, %" PRIu32 " still playing after %" PRIu32 " s\n",
+		Borders, Batch.Count - Borders - Unfinished, Unfinished, Seconds);
+
+	FinalizeGameBatch(&Batch);
+	return 0;
+}
@@ -0,0 +1,338 @@
+/*
+ * Hocoslamfy, background strip test and benchmark
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// Checks that drawing the background in the strips cut by CutBackground, as
+// DrawBackground does, gives the same pixels as blending every pixel of every
+// layer in turn, with the layers scrolled to random places. Then measures how
+// long a frame takes either way, against SDL 1.2's C per-pixel alpha blitter
+// for the layers, as the background was drawn before it was cut into strips.
+// The layers aren't loaded from data/, which needs SDL_image. They are made
+// with the same sizes and with soft wavy edges on the same rows, so that
+// their rows are cut the same way.
+// Usage: hocobg [frames [seed]]
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <time.h>
+
+#include "init.h"
+#include "bg.h"
+#include "blend.h"
+#include "span.h"
+#include "strip.h"
+#include "args.h"
+
+// The width of the images of the layers. The part of it that is drawn
+// scrolls over 160 pixels.
+#define LAYER_WIDTH  480
+#define LAYER_SCROLL 160
+
+// The number of frames drawn each way in the benchmark.
+#define BENCHMARK_FRAMES 5000
+
+// The shape of the opaque part of a layer: its top edge waves between
+// TopMin and TopMax, and its bottom edge, if it has one, between BottomMin
+// and BottomMax. The pixels on the edges are partly transparent.
+struct LayerShape
+{
+	bool     Alpha;
+	uint32_t TopMin;
+	uint32_t TopMax;
+	bool     HasBottom;
+	uint32_t BottomMin;
+	uint32_t BottomMax;
+};
+
+static const struct LayerShape Shapes[BG_LAYER_COUNT] = {
+	{ false,  0,  0, false,  0,  0 }, /* Sky */
+	{ true,   1, 59, false,  0,  0 }, /* Mountains */
+	{ true,   0,  0, true,  21, 28 }, /* Clouds3 */
+	{ true,   0,  0, true,  19, 28 }, /* Clouds2 */
+	{ true,   0,  0, true,  24, 32 }, /* Clouds1 */
+	{ true,   0,  5, false,  0,  0 }, /* Grass3 */
+	{ true,   0,  8, false,  0,  0 }, /* Grass2 */
+	{ true,   0, 11, false,  0,  0 }  /* Grass1 */
+};
+
+struct Layer
+{
+	// The pixels as SDL would have them: not premultiplied.
+	uint32_t*        Pixels;
+	struct SpanImage Spans;
+};
+
+static uint64_t RandomState;
+
+static uint32_t Random(void)
+{
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 7;
+	RandomState ^= RandomState << 17;
+	return (uint32_t) (RandomState >> 32);
+}
+
+static double Seconds(const struct timespec* Start, const struct timespec* End)
+{
+	return (End->tv_sec - Start->tv_sec) + (End->tv_nsec - Start->tv_nsec) / 1e9;
+}
+
+// Returns where an edge that waves Waves times across a layer, between Min
+// and Max, is at X.
+static uint32_t Edge(uint32_t Min, uint32_t Max, uint32_t Waves, uint32_t X, double Phase)
+{
+	return Min + (uint32_t) floor((Max - Min) * (1 + sin(2 * M_PI * Waves * X / LAYER_WIDTH + Phase)) / 2 + 0.5);
+}
+
+static void MakeLayer(struct Layer* Layer, uint32_t Index)
+{
+	const struct LayerShape* Shape = &Shapes[Index];
+	uint32_t Height = BG_Height[Index], x, y;
+
+	if ((Layer->Pixels = malloc(LAYER_WIDTH * Height * sizeof(uint32_t))) == NULL)
+	{
+		printf("Out of memory\n");
+		exit(2);
+	}
+	for (x = 0; x < LAYER_WIDTH; x++)
+	{
+		uint32_t Top = Edge(Shape->TopMin, Shape->TopMax, 2 + Index % 5, x, 0),
+		         Bottom = Shape->HasBottom ? Edge(Shape->BottomMin, Shape->BottomMax, 3 + Index % 4, x, 1) : Height + 1;
+		for (y = 0; y < Height; y++)
+		{
+			uint32_t Alpha;
+			if (!Shape->Alpha)
+				Alpha = 0xFF;
+			else if (y < Top || y >= Bottom)
+				Alpha = 0;
+			else if (y == Top || y == Bottom - 1)
+				Alpha = 1 + Random() % 254;
+			else
+				Alpha = 0xFF;
+			Layer->Pixels[y * LAYER_WIDTH + x] = Alpha << 24 | (Random() & 0xFFFFFF);
+		}
+	}
+	if (!MakeSpanImage(&Layer->Spans, Layer->Pixels, LAYER_WIDTH, Height, LAYER_WIDTH * sizeof(uint32_t)))
+	{
+		printf("Out of memory\n");
+		exit(2);
+	}
+}
+
+// Returns whether a row of a layer has no transparency at all.
+static bool IsRowOpaque(const struct Layer* Layer, uint32_t Y)
+{
+	uint32_t x;
+	for (x = 0; x < LAYER_WIDTH; x++)
+		if ((Layer->Pixels[Y * LAYER_WIDTH + x] >> 24) != 0xFF)
+			return false;
+	return true;
+}
+
+// What SDL 1.2's C blitter does for 32-bit pixels with alpha, without
+// premultiplication.
+static void BlendLikeSDL(uint32_t* Dest, const uint32_t* Source, uint32_t Count)
+{
+	uint32_t i;
+	for (i = 0; i < Count; i++)
+	{
+		uint32_t S = Source[i], D = Dest[i], Alpha = S >> 24;
+		if (Alpha == 0xFF)
+			Dest[i] = (S & 0xFFFFFF) | (D & 0xFF000000);
+		else
+		{
+			uint32_t S1 = S & 0xFF00FF, D1 = D & 0xFF00FF;
+			D1 = (D1 + ((S1 - D1) * Alpha >> 8)) & 0xFF00FF;
+			S &= 0xFF00;
+			uint32_t D2 = D & 0xFF00;
+			D2 = (D2 + ((S - D2) * Alpha >> 8)) & 0xFF00;
+			Dest[i] = D1 | D2 | (D & 0xFF000000);
+		}
+	}
+}
+
+// Draws every row of every layer: copied for the sky, which has no alpha,
+// and blended for the others, with SDL 1.2's blitter or with Blend on the
+// premultiplied pixels.
+static void DrawLayers(const struct Layer* Layers, const uint32_t* X, uint32_t* Screen, TBlendKernel Blend)
+{
+	uint32_t i, y;
+	for (i = 0; i < BG_LAYER_COUNT; i++)
+		for (y = 0; y < BG_Height[i] && BG_StartY[i] + y < SCREEN_HEIGHT; y++)
+		{
+			uint32_t* Dest = &Screen[(BG_StartY[i] + y) * SCREEN_WIDTH];
+			if (!Shapes[i].Alpha)
+				memcpy(Dest, &Layers[i].Pixels[y * LAYER_WIDTH + X[i]], SCREEN_WIDTH * sizeof(uint32_t));
+			else if (Blend == NULL)
+				BlendLikeSDL(Dest, &Layers[i].Pixels[y * LAYER_WIDTH + X[i]], SCREEN_WIDTH);
+			else
+				Blend(Dest, &Layers[i].Spans.Pixels[y * LAYER_WIDTH + X[i]], SCREEN_WIDTH);
+		}
+}
+
+// Draws the strips as DrawBackground does: opaque ones are copied, and the
+// others are blitted from span images.
+static void DrawStrips(const struct Layer* Layers, const struct LayerStrip* Strips, uint32_t Count, const uint32_t* X, uint32_t* Screen)
+{
+	const struct SpanRect Clip = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+	uint32_t i, y;
+	for (i = 0; i < Count; i++)
+	{
+		const struct LayerStrip* Strip = &Strips[i];
+		const struct Layer* Layer = &Layers[Strip->Layer];
+		if (Strip->Opaque)
+			for (y = 0; y < Strip->Height; y++)
+				memcpy(&Screen[(Strip->StartY + y) * SCREEN_WIDTH],
+					&Layer->Spans.Pixels[(Strip->SourceY + y) * LAYER_WIDTH + X[Strip->Layer]],
+					SCREEN_WIDTH * sizeof(uint32_t));
+		else
+		{
+			struct SpanRect Source = { X[Strip->Layer], Strip->SourceY, SCREEN_WIDTH, Strip->Height };
+			BlitSpanImage(&Layer->Spans, &Source, Screen, SCREEN_WIDTH * sizeof(uint32_t), 0, Strip->StartY, &Clip);
+		}
+	}
+}
+
+// Returns the largest difference between the red, green and blue bytes of
+// the pixels of two screens.
+static uint32_t Difference(const uint32_t* A, const uint32_t* B)
+{
+	uint32_t Result = 0, i, j;
+	for (i = 0; i < SCREEN_WIDTH * SCREEN_HEIGHT; i++)
+		for (j = 0; j < 24; j += 8)
+		{
+			int32_t D = (int32_t) ((A[i] >> j) & 0xFF) - (int32_t) ((B[i] >> j) & 0xFF);
+			if (D < 0)
+				D = -D;
+			if ((uint32_t) D > Result)
+				Result = D;
+		}
+	return Result;
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t Frames = 2000;
+	RandomState = 1;
+	if (argc > 3
+	 || (argc > 1 && !ParseUint32(argv[1], 1, &Frames))
+	 || (argc > 2 && !ParseUint64(argv[2], &RandomState)))
+	{
+		fprintf(stderr, "Usage: %s [frames [seed]]\n", argv[0]);
+		return 2;
+	}
+	if (RandomState == 0)
+		RandomState = 1;
+
+	const struct BlendKernel* Kernels;
+	struct Layer Layers[BG_LAYER_COUNT];
+	bool Opaque[BG_LAYER_COUNT][SCREEN_HEIGHT];
+	struct LayerStrip Strips[MAX_BG_STRIPS];
+	static uint32_t Screen[SCREEN_WIDTH * SCREEN_HEIGHT], Expected[SCREEN_WIDTH * SCREEN_HEIGHT],
+	                LikeSDL[SCREEN_WIDTH * SCREEN_HEIGHT];
+	uint32_t X[BG_LAYER_COUNT], Count, OpaqueRows = 0, BlendedRows = 0, LayerRows = 0,
+	         Mismatches = 0, MaxDifference = 0, i, j;
+
+	GetBlendKernels(&Kernels);
+	for (i = 0; i < BG_LAYER_COUNT; i++)
+	{
+		MakeLayer(&Layers[i], i);
+		for (j = 0; j < BG_Height[i] && BG_StartY[i] + j < SCREEN_HEIGHT; j++)
+		{
+			Opaque[i][j] = IsRowOpaque(&Layers[i], j);
+			LayerRows++;
+		}
+	}
+	Count = CutBackground(Opaque, Strips);
+	if (Count > MAX_BG_STRIPS)
+	{
+		printf("More than %u strips\n", MAX_BG_STRIPS);
+		return 1;
+	}
+	for (i = 0; i < Count; i++)
+	{
+		if (Strips[i].Opaque)
+			OpaqueRows += Strips[i].Height;
+		else
+			BlendedRows += Strips[i].Height;
+	}
+	printf("%" PRIu32 " layer rows cut into %" PRIu32 " strips: %" PRIu32 " opaque rows, %" PRIu32 " blended rows\n",
+		LayerRows, Count, OpaqueRows, BlendedRows);
+
+	for (i = 0; i < Frames; i++)
+	{
+		for (j = 0; j < BG_LAYER_COUNT; j++)
+			X[j] = Random() % (LAYER_SCROLL + 1);
+		for (j = 0; j < SCREEN_WIDTH * SCREEN_HEIGHT; j++)
+			Screen[j] = Random();
+		memcpy(Expected, Screen, sizeof(Screen));
+		memcpy(LikeSDL, Screen, sizeof(Screen));
+		DrawLayers(Layers, X, Expected, Kernels[0].Blend);
+		DrawLayers(Layers, X, LikeSDL, NULL);
+		DrawStrips(Layers, Strips, Count, X, Screen);
+		if (memcmp(Screen, Expected, sizeof(Screen)) != 0)
+		{
+			if (Mismatches++ < 10)
+				printf("Mismatch on frame %" PRIu32 "\n", i);
+		}
+		uint32_t Diff = Difference(Screen, LikeSDL);
+		if (Diff > MaxDifference)
+			MaxDifference = Diff;
+	}
+	printf("%" PRIu32 " frames: %" PRIu32 " mismatches; at most %" PRIu32 " away from SDL 1.2\n",
+		Frames, Mismatches, MaxDifference);
+
+	struct timespec Start, End;
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (i = 0; i < BENCHMARK_FRAMES; i++)
+	{
+		for (j = 0; j < BG_LAYER_COUNT; j++)
+			X[j] = (i * (j + 1)) % (LAYER_SCROLL + 1);
+		DrawLayers(Layers, X, Screen, NULL);
+		__asm__ __volatile__ ("" : : "m" (Screen) : "memory");
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	double LayerTime = Seconds(&Start, &End);
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (i = 0; i < BENCHMARK_FRAMES; i++)
+	{
+		for (j = 0; j < BG_LAYER_COUNT; j++)
+			X[j] = (i * (j + 1)) % (LAYER_SCROLL + 1);
+		DrawStrips(Layers, Strips, Count, X, Screen);
+		__asm__ __volatile__ ("" : : "m" (Screen) : "memory");
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	double StripTime = Seconds(&Start, &End);
+
+	printf("Layers with SDL 1.2 (C): %.1f us per frame, strips: %.1f us per frame\n",
+		LayerTime / BENCHMARK_FRAMES * 1e6, StripTime / BENCHMARK_FRAMES * 1e6);
+
+	for (i = 0; i < BG_LAYER_COUNT; i++)
+	{
+		FreeSpanImage(&Layers[i].Spans);
+		free(Layers[i].Pixels);
+	}
+	return Mismatches != 0 || MaxDifference > 2 ? 1 : 0;
+}
@@ -0,0 +1,234 @@
+/*
+ * Hocoslamfy, blending kernel test and benchmark
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// Checks that every blending kernel gives the same pixels as the portable
+// one, and that they are within 1 of SDL 1.2's per-pixel alpha blits for
+// every alpha, source and destination byte, then measures how long each
+// takes.
+// Usage: hocoblend [rounds [seed]]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <time.h>
+
+#include "blend.h"
+#include "args.h"
+
+// The number of pixels blended at once in the benchmark, as in a row of the
+// screen.
+#define ROW 320
+
+static uint64_t RandomState;
+
+static uint32_t Random(void)
+{
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 7;
+	RandomState ^= RandomState << 17;
+	return (uint32_t) (RandomState >> 32);
+}
+
+static double Seconds(const struct timespec* Start, const struct timespec* End)
+{
+	return (End->tv_sec - Start->tv_sec) + (End->tv_nsec - Start->tv_nsec) / 1e9;
+}
+
+// What SDL 1.2's C blitter does for a 32-bit pixel with alpha, without
+// premultiplication.
+static inline uint32_t BlendPixelLikeSDL(uint32_t S, uint32_t D)
+{
+	uint32_t Alpha = S >> 24;
+	if (Alpha == 0xFF)
+		return (S & 0xFFFFFF) | (D & 0xFF000000);
+	uint32_t S1 = S & 0xFF00FF, D1 = D & 0xFF00FF;
+	D1 = (D1 + ((S1 - D1) * Alpha >> 8)) & 0xFF00FF;
+	S &= 0xFF00;
+	uint32_t D2 = D & 0xFF00;
+	D2 = (D2 + ((S - D2) * Alpha >> 8)) & 0xFF00;
+	return D1 | D2 | (D & 0xFF000000);
+}
+
+static void BlendLikeSDL(uint32_t* Dest, const uint32_t* Source, uint32_t Count)
+{
+	uint32_t i;
+	for (i = 0; i < Count; i++)
+		Dest[i] = BlendPixelLikeSDL(Source[i], Dest[i]);
+}
+
+// The same, without letting the compiler vectorize it. SDL 1.2 blends one
+// pixel at a time, and the scalar kernel is only used where there is nothing
+// to vectorize with, such as on MIPS, so this is what it's compared with.
+#if defined(__GNUC__) && !defined(__clang__)
+__attribute__((optimize("no-tree-vectorize")))
+#endif
+static void BlendLikeSDLScalar(uint32_t* Dest, const uint32_t* Source, uint32_t Count)
+{
+	uint32_t i;
+#ifdef __clang__
+#pragma clang loop vectorize(disable) interleave(disable)
+#endif
+	for (i = 0; i < Count; i++)
+		Dest[i] = BlendPixelLikeSDL(Source[i], Dest[i]);
+}
+
+// Returns the largest difference between the red, green and blue bytes of
+// two pixels.
+static uint32_t Difference(uint32_t A, uint32_t B)
+{
+	uint32_t Result = 0, i;
+	for (i = 0; i < 24; i += 8)
+	{
+		int32_t D = (int32_t) ((A >> i) & 0xFF) - (int32_t) ((B >> i) & 0xFF);
+		if (D < 0)
+			D = -D;
+		if ((uint32_t) D > Result)
+			Result = D;
+	}
+	return Result;
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t Rounds = 100000;
+	RandomState = 1;
+	if (argc > 3
+	 || (argc > 1 && !ParseUint32(argv[1], 1, &Rounds))
+	 || (argc > 2 && !ParseUint64(argv[2], &RandomState)))
+	{
+		fprintf(stderr, "Usage: %s [rounds [seed]]\n", argv[0]);
+		return 2;
+	}
+	if (RandomState == 0)
+		RandomState = 1;
+
+	const struct BlendKernel* Kernels;
+	uint32_t KernelCount = GetBlendKernels(&Kernels), Mismatches = 0, MaxDifference = 0, a, s, d, k, i;
+	uint32_t Straight[256], Source[256], Dest[256], Expected[256], Actual[256];
+
+	// Every alpha and source byte, over every destination byte. The other
+	// bytes of each pixel vary too, so that red, green and blue all go
+	// through every value.
+	for (d = 0; d < 256; d++)
+		Dest[d] = (d ^ 0xA5) << 24 | d << 16 | (d ^ 0x5A) << 8 | (255 - d);
+	for (a = 0; a < 256; a++)
+		for (s = 0; s < 256; s++)
+		{
+			for (d = 0; d < 256; d++)
+				Straight[d] = a << 24 | (255 - s) << 16 | s << 8 | (s ^ d);
+			memcpy(Source, Straight, sizeof(Source));
+			PremultiplyPixels(Source, 256);
+
+			memcpy(Expected, Dest, sizeof(Expected));
+			BlendLikeSDL(Expected, Straight, 256);
+			memcpy(Actual, Dest, sizeof(Actual));
+			Kernels[0].Blend(Actual, Source, 256);
+			for (d = 0; d < 256; d++)
+			{
+				uint32_t Diff = Difference(Expected[d], Actual[d]);
+				if (Diff > MaxDifference)
+					MaxDifference = Diff;
+			}
+			memcpy(Expected, Actual, sizeof(Expected));
+			for (k = 1; k < KernelCount; k++)
+			{
+				memcpy(Actual, Dest, sizeof(Actual));
+				Kernels[k].Blend(Actual, Source, 256);
+				if (memcmp(Actual, Expected, sizeof(Actual)) != 0)
+				{
+					if (Mismatches++ < 10)
+						printf("%s differs from %s with alpha %" PRIu32 ", source %" PRIu32 "\n",
+							Kernels[k].Name, Kernels[0].Name, a, s);
+				}
+			}
+		}
+
+	// Random pixels, at random offsets and of random lengths, for the parts
+	// of each kernel that work on fewer pixels than it does at once.
+	for (i = 0; i < 100000; i++)
+	{
+		uint32_t Offset = Random() % 16, Count = Random() % (256 - 16);
+		for (d = 0; d < 256; d++)
+		{
+			Source[d] = Random();
+			Dest[d] = Random();
+		}
+		PremultiplyPixels(Source, 256);
+		memcpy(Expected, Dest, sizeof(Expected));
+		Kernels[0].Blend(&Expected[Offset], &Source[Offset], Count);
+		for (k = 1; k < KernelCount; k++)
+		{
+			memcpy(Actual, Dest, sizeof(Actual));
+			Kernels[k].Blend(&Actual[Offset], &Source[Offset], Count);
+			if (memcmp(Actual, Expected, sizeof(Actual)) != 0)
+			{
+				if (Mismatches++ < 10)
+					printf("%s differs from %s on %" PRIu32 " random pixels at offset %" PRIu32 "\n",
+						Kernels[k].Name, Kernels[0].Name, Count, Offset);
+			}
+		}
+	}
+	printf("%" PRIu32 " kernels: %" PRIu32 " mismatches; at most %" PRIu32 " away from SDL 1.2\n",
+		KernelCount, Mismatches, MaxDifference);
+
+	// Time SDL 1.2's blend and each kernel on rows of partly transparent
+	// pixels, the only ones span sprites blend.
+	uint32_t Row[ROW], Premultiplied[ROW], Screen[ROW];
+	struct timespec Start, End;
+	for (i = 0; i < ROW; i++)
+	{
+		Row[i] = (1 + Random() % 254) << 24 | (Random() & 0xFFFFFF);
+		Screen[i] = Random();
+	}
+	memcpy(Premultiplied, Row, sizeof(Row));
+	PremultiplyPixels(Premultiplied, ROW);
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (i = 0; i < Rounds; i++)
+	{
+		BlendLikeSDL(Screen, Row, ROW);
+		__asm__ __volatile__ ("" : : "m" (Screen) : "memory");
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	printf("SDL 1.2 (C, as compiled here): %.3f ns per pixel\n", Seconds(&Start, &End) / ((double) Rounds * ROW) * 1e9);
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (i = 0; i < Rounds; i++)
+	{
+		BlendLikeSDLScalar(Screen, Row, ROW);
+		__asm__ __volatile__ ("" : : "m" (Screen) : "memory");
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	printf("SDL 1.2 (C, one pixel at a time): %.3f ns per pixel\n", Seconds(&Start, &End) / ((double) Rounds * ROW) * 1e9);
+	for (k = 0; k < KernelCount; k++)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &Start);
+		for (i = 0; i < Rounds; i++)
+		{
+			Kernels[k].Blend(Screen, Premultiplied, ROW);
+			__asm__ __volatile__ ("" : : "m" (Screen) : "memory");
+		}
+		clock_gettime(CLOCK_MONOTONIC, &End);
+		printf("%s: %.3f ns per pixel\n", Kernels[k].Name, Seconds(&Start, &End) / ((double) Rounds * ROW) * 1e9);
+	}
+
+	return Mismatches != 0 || MaxDifference > 1 ? 1 : 0;
+}
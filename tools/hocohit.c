@@ -0,0 +1,256 @@
+/*
+ * Hocoslamfy, collision hitbox test and benchmark
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// Checks that CollideHitboxes4, and its scalar form CollideHitboxes4Scalar,
+// agree with CollidesWithRectangle on column rectangles, for random points
+// and for points on and next to every edge, then measures how long each
+// takes.
+// Usage: hocohit [rectangles [seed]]
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <time.h>
+
+#include "fixed.h"
+#include "init.h"
+#include "game.h"
+#include "collision.h"
+#include "args.h"
+
+// The number of rectangles kept in hitboxes at once, as in a game.
+#define SLOTS 16
+
+// The number of random points tested against each group of rectangles.
+#define RANDOM_POINTS 4096
+
+// The number of times each point is tested against all the rectangles in
+// the benchmark.
+#define ROUNDS 256
+
+struct Rectangle
+{
+	fixed Left;
+	fixed Top;
+	fixed Right;
+	fixed Bottom;
+};
+
+static uint64_t RandomState;
+
+static uint32_t Random(void)
+{
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 7;
+	RandomState ^= RandomState << 17;
+	return (uint32_t) (RandomState >> 32);
+}
+
+// Returns a random integer between Low and High, inclusive.
+static fixed RandomBetween(fixed Low, fixed High)
+{
+	return Low + (fixed) (Random() % (uint32_t) (High - Low + 1));
+}
+
+static double Seconds(const struct timespec* Start, const struct timespec* End)
+{
+	return (End->tv_sec - Start->tv_sec) + (End->tv_nsec - Start->tv_nsec) / 1e9;
+}
+
+// Makes a rectangle as wide as a column and at least as high as the shortest
+// column (FIELD_HEIGHT / 16), within a field and a column's width around it.
+// Slots left empty by the game have no height; one in 8 is like that.
+static void MakeRectangle(struct Rectangle* Rectangle)
+{
+	Rectangle->Left  = RandomBetween(-FIXED_RECT_WIDTH, FIXED_FIELD_WIDTH);
+	Rectangle->Right = Rectangle->Left + FIXED_RECT_WIDTH;
+	if (Random() % 8 == 0)
+		Rectangle->Top = Rectangle->Bottom = 0;
+	else
+	{
+		Rectangle->Bottom = RandomBetween(-FIXED_FIELD_HEIGHT / 4, FIXED_FIELD_HEIGHT);
+		Rectangle->Top    = Rectangle->Bottom + RandomBetween(FIXED_FIELD_HEIGHT / 16, FIXED_FIELD_HEIGHT);
+	}
+}
+
+// Returns the mask CollideHitboxes4 should return for the 4 rectangles
+// starting at Slot.
+static uint32_t Expected4(fixed X, fixed Y, const struct Rectangle* Rectangles, uint32_t Slot)
+{
+	uint32_t Result = 0, i;
+	for (i = 0; i < 4; i++)
+	{
+		const struct Rectangle* R = &Rectangles[Slot + i];
+		if (CollidesWithRectangle(X, Y, R->Left, R->Top, R->Right, R->Bottom))
+			Result |= 1 << i;
+	}
+	return Result;
+}
+
+// Tests (X, Y) against all the rectangles both ways. Returns the number of
+// groups of 4 on which they disagree, printing the first few.
+static uint32_t Check(fixed X, fixed Y, const struct Rectangle* Rectangles, const struct Hitboxes* Hitboxes)
+{
+	static uint32_t Printed = 0;
+	uint32_t Mismatches = 0, Slot;
+	for (Slot = 0; Slot < SLOTS; Slot += 4)
+	{
+		uint32_t Expected = Expected4(X, Y, Rectangles, Slot),
+		         Actual   = CollideHitboxes4(X, Y, Hitboxes, Slot),
+		         Scalar   = CollideHitboxes4Scalar(X, Y, Hitboxes, Slot);
+		if (Expected != Actual || Expected != Scalar)
+		{
+			Mismatches++;
+			if (Printed++ < 10)
+				printf("Mismatch at (%" PRId32 ", %" PRId32 "), slots %" PRIu32 "..%" PRIu32 ": expected %" PRIx32 ", got %" PRIx32 " (scalar %" PRIx32 ")\n",
+					X, Y, Slot, Slot + 3, Expected, Actual, Scalar);
+		}
+	}
+	return Mismatches;
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t Count = 100000;
+	RandomState = 1;
+	if (argc > 3
+	 || (argc > 1 && !ParseUint32(argv[1], 1, &Count))
+	 || (argc > 2 && !ParseUint64(argv[2], &RandomState)))
+	{
+		fprintf(stderr, "Usage: %s [rectangles [seed]]\n", argv[0]);
+		return 2;
+	}
+	if (RandomState == 0)
+		RandomState = 1;
+
+	struct Rectangle Rectangles[SLOTS];
+	fixed Storage[8][SLOTS];
+	struct Hitboxes Hitboxes;
+	uint32_t Groups = (Count + SLOTS - 1) / SLOTS, Tests = 0, Mismatches = 0, i, j, k, l;
+	for (i = 0; i < 2; i++)
+	{
+		Hitboxes.Left[i]   = Storage[i * 4];
+		Hitboxes.Top[i]    = Storage[i * 4 + 1];
+		Hitboxes.Right[i]  = Storage[i * 4 + 2];
+		Hitboxes.Bottom[i] = Storage[i * 4 + 3];
+	}
+
+	for (i = 0; i < Groups; i++)
+	{
+		for (j = 0; j < SLOTS; j++)
+		{
+			MakeRectangle(&Rectangles[j]);
+			SetHitboxes(&Hitboxes, j, Rectangles[j].Left, Rectangles[j].Top, Rectangles[j].Right, Rectangles[j].Bottom);
+		}
+		for (j = 0; j < RANDOM_POINTS / SLOTS; j++)
+		{
+			Mismatches += Check(RandomBetween(-FIXED_RECT_WIDTH, FIXED_FIELD_WIDTH + FIXED_RECT_WIDTH),
+				RandomBetween(-FIXED_FIELD_HEIGHT / 4, FIXED_FIELD_HEIGHT + FIXED_FIELD_HEIGHT / 4),
+				Rectangles, &Hitboxes);
+			Tests++;
+		}
+		// Points on and next to the edges of every hitbox, where the strict
+		// comparisons of both tests matter, along a random line across each
+		// and at each corner.
+		for (j = 0; j < SLOTS; j++)
+		{
+			for (k = 0; k < 2; k++)
+			{
+				fixed Xs[2] = { Hitboxes.Left[k][j], Hitboxes.Right[k][j] },
+				      Ys[2] = { Hitboxes.Bottom[k][j], Hitboxes.Top[k][j] };
+				fixed X = RandomBetween(Xs[0], Xs[1]), Y = RandomBetween(Ys[0], Ys[1]);
+				for (l = 0; l < 2; l++)
+				{
+					int32_t d, e;
+					for (d = -1; d <= 1; d++)
+					{
+						Mismatches += Check(Xs[l] + d, Y, Rectangles, &Hitboxes);
+						Mismatches += Check(X, Ys[l] + d, Rectangles, &Hitboxes);
+						for (e = -1; e <= 1; e++)
+							Mismatches += Check(Xs[l] + d, Ys[l] + e, Rectangles, &Hitboxes);
+						Tests += 5;
+					}
+				}
+			}
+		}
+	}
+	printf("%" PRIu32 " rectangles, %" PRIu32 " points against %u rectangles each: %" PRIu32 " mismatched groups of 4\n",
+		Groups * SLOTS, Tests, SLOTS, Mismatches);
+
+	// Time all three on the last group of rectangles, with random points.
+	fixed Xs[RANDOM_POINTS], Ys[RANDOM_POINTS];
+	for (i = 0; i < RANDOM_POINTS; i++)
+	{
+		Xs[i] = RandomBetween(-FIXED_RECT_WIDTH, FIXED_FIELD_WIDTH + FIXED_RECT_WIDTH);
+		Ys[i] = RandomBetween(0, FIXED_FIELD_HEIGHT);
+	}
+	struct timespec Start, End;
+	uint32_t EdgeHits = 0, PointHits = 0, ScalarHits = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (i = 0; i < ROUNDS; i++)
+		for (j = 0; j < RANDOM_POINTS; j++)
+			for (k = 0; k < SLOTS; k += 4)
+			{
+				EdgeHits += __builtin_popcount(Expected4(Xs[j], Ys[j], Rectangles, k));
+				__asm__ __volatile__ ("" : : "m" (Rectangles) : "memory");
+			}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	double EdgeTime = Seconds(&Start, &End);
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (i = 0; i < ROUNDS; i++)
+		for (j = 0; j < RANDOM_POINTS; j++)
+			for (k = 0; k < SLOTS; k += 4)
+			{
+				PointHits += __builtin_popcount(CollideHitboxes4(Xs[j], Ys[j], &Hitboxes, k));
+				__asm__ __volatile__ ("" : : "m" (Storage) : "memory");
+			}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	double PointTime = Seconds(&Start, &End);
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (i = 0; i < ROUNDS; i++)
+		for (j = 0; j < RANDOM_POINTS; j++)
+			for (k = 0; k < SLOTS; k += 4)
+			{
+				ScalarHits += __builtin_popcount(CollideHitboxes4Scalar(Xs[j], Ys[j], &Hitboxes, k));
+				__asm__ __volatile__ ("" : : "m" (Storage) : "memory");
+			}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	double ScalarTime = Seconds(&Start, &End);
+
+	double Pairs = (double) ROUNDS * RANDOM_POINTS * SLOTS;
+	printf("CollidesWithRectangle: %.2f ns per rectangle (%" PRIu32 " hits)\n",
+		EdgeTime / Pairs * 1e9, EdgeHits);
+	printf("CollideHitboxes4 (%s): %.2f ns per rectangle (%" PRIu32 " hits)\n",
+#ifdef __SSE2__
+		"SSE2",
+#else
+		"scalar",
+#endif
+		PointTime / Pairs * 1e9, PointHits);
+	printf("CollideHitboxes4Scalar: %.2f ns per rectangle (%" PRIu32 " hits)\n",
+		ScalarTime / Pairs * 1e9, ScalarHits);
+
+	return Mismatches != 0 || EdgeHits != PointHits || EdgeHits != ScalarHits ? 1 : 0;
+}
@@ -0,0 +1,215 @@
+/*
+ * Hocoslamfy, seed rating tool
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// Rates seeds by how well a noisy bot does on them, and writes them to a seed
+// catalog (see catalog.h) that the game can look them up in.
+// Usage: hocorate catalog-file first-seed seeds [plays [seconds [threads]]]
+// The seeds from first-seed to first-seed + seeds - 1 are each played plays
+// times, for at most the given number of seconds, by BatchAutopilotController
+// aiming off the middle of the gaps by a random amount that it changes every
+// so often, like a player who isn't always precise. The survival curve of
+// each seed, the share of games that passed each number of columns, is
+// written to standard output as CSV.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <time.h>
+
+#include "sim.h"
+#include "batch.h"
+#include "rng.h"
+#include "catalog.h"
+#include "args.h"
+
+// The bot aims up to this far above or below the middle of the gaps.
+#define NOISE_AIM     FIXED(0.15)
+// It picks another place to aim at this many times a second, on average.
+#define NOISE_CHANGES 8
+
+// The stream of the noise of each game's bot; see rng.h.
+#define RANDOM_STREAM_NOISE 2
+
+// The scores beyond which survival curves aren't written.
+#define MAX_CURVE_SCORE 200
+
+struct NoisyBot
+{
+	struct Random* Noise;
+	fixed*         Aim;
+};
+
+static void NoisyController(const struct GameBatch* Batch, const struct BatchColumns* Columns,
+	uint32_t First, uint32_t Count, int32_t* Boost, void* Data)
+{
+	struct NoisyBot* Bot = Data;
+	uint32_t i;
+	for (i = First; i < First + Count; i++)
+		if (RandomBelow(&Bot->Noise[i], 1000) < NOISE_CHANGES)
+			Bot->Aim[i] = (fixed) RandomBelow(&Bot->Noise[i], 2 * NOISE_AIM + 1) - NOISE_AIM;
+	BatchAutopilotController(Batch, Columns, First, Count, Boost, Bot->Aim);
+}
+
+static int CompareScores(const void* A, const void* B)
+{
+	uint32_t Left = *(const uint32_t*) A, Right = *(const uint32_t*) B;
+	return Left < Right ? -1 : Left > Right;
+}
+
+// Sorts ratings by decreasing mean score, so from the easiest seed.
+static int CompareMeanScores(const void* A, const void* B)
+{
+	const struct SeedRating* Left = A;
+	const struct SeedRating* Right = B;
+	return Left->MeanScore > Right->MeanScore ? -1 : Left->MeanScore < Right->MeanScore;
+}
+
+// Plays a seed Plays times and rates it, leaving its Difficulty for later.
+static bool RateSeed(struct GameBatch* Batch, struct NoisyBot* Bot, uint64_t Seed, uint32_t Threads,
+	uint32_t* Scores, struct SeedRating* Rating)
+{
+	uint32_t Plays = Batch->Count, i, j;
+	uint64_t Total = 0;
+
+	// All games are played with the same seed, but each bot has its own noise.
+	for (i = 0; i < Batch->Stride; i++)
+	{
+		Batch->PlayerY[i] = FIXED_PLAYER_START_Y;
+		Batch->PlayerSpeed[i] = 0;
+		Batch->Playing[i] = i < Plays ? -1 : 0;
+		Batch->Score[i] = 0;
+		Batch->Time[i] = 0;
+		InitializeGapGenerator(&Batch->Gaps[i], Seed, &Batch->Parameters);
+		SeedRandom(&Bot->Noise[i], Seed * Plays + i, RANDOM_STREAM_NOISE);
+		Bot->Aim[i] = 0;
+	}
+	RunGameBatch(Batch, Threads, NoisyController, Bot);
+
+	memcpy(Scores, Batch->Score, Plays * sizeof(uint32_t));
+	qsort(Scores, Plays, sizeof(uint32_t), CompareScores);
+	for (i = 0; i < Plays; i++)
+		Total += Scores[i];
+
+	*Rating = (struct SeedRating) {
+		.Seed = Seed,
+		.Plays = Plays,
+		.MeanScore = (uint32_t) ((Total * 100 + Plays / 2) / Plays),
+		.MedianScore = (uint16_t) (Scores[Plays / 2] < UINT16_MAX ? Scores[Plays / 2] : UINT16_MAX),
+		.Difficulty = 0
+	};
+
+	// Scores are sorted, so the games that passed a number of columns are
+	// those from the first one with at least that score.
+	printf("%" PRIu64, Seed);
+	for (i = 0, j = 0; i <= MAX_CURVE_SCORE; i++)
+	{
+		while (j < Plays && Scores[j] < i)
+			j++;
+		printf(",%.4f", (double) (Plays - j) / Plays);
+	}
+	printf("\n");
+	for (i = 0; i < CATALOG_CHECKPOINTS; i++)
+	{
+		for (j = 0; j < Plays && Scores[j] < CatalogCheckpoints[i]; j++)
+			;
+		Rating->Survival[i] = (uint16_t) (((uint64_t) (Plays - j) * 10000 + Plays / 2) / Plays);
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* Path    = argv[1];
+	uint64_t    First   = 0;
+	uint32_t    Seeds   = 0;
+	uint32_t    Plays   = 2048;
+	uint32_t    Seconds = 300;
+	uint32_t    Threads = 0;
+	if (argc < 4 || argc > 7
+	 || !ParseUint64(argv[2], &First)
+	 || !ParseUint32(argv[3], 0, &Seeds)
+	 || (argc > 4 && !ParseUint32(argv[4], 0, &Plays))
+	 || (argc > 5 && !ParseUint32(argv[5], 1, &Seconds))
+	 || (argc > 6 && !ParseUint32(argv[6], 0, &Threads)))
+	{
+		fprintf(stderr, "Usage: %s catalog-file first-seed seeds [plays [seconds [threads]]]\n", argv[0]);
+		return 2;
+	}
+	struct GameBatch Batch;
+	struct NoisyBot Bot;
+	struct timespec Start, End;
+	uint32_t i;
+
+	if (Seeds == 0 || Plays == 0)
+	{
+		fprintf(stderr, "At least one seed must be played at least once\n");
+		return 2;
+	}
+	struct SeedRating* Ratings = malloc(Seeds * sizeof(struct SeedRating));
+	uint32_t* Scores = malloc(Plays * sizeof(uint32_t));
+	if (Ratings == NULL || Scores == NULL
+	 || !InitializeGameBatch(&Batch, Plays, Seconds * 1000, First, &DefaultParameters))
+	{
+		fprintf(stderr, "Failed to allocate a batch of %" PRIu32 " games\n", Plays);
+		return 1;
+	}
+	Bot.Noise = malloc(Batch.Stride * sizeof(struct Random));
+	Bot.Aim = malloc(Batch.Stride * sizeof(fixed));
+	if (Bot.Noise == NULL || Bot.Aim == NULL)
+	{
+		fprintf(stderr, "Failed to allocate the bots of %" PRIu32 " games\n", Plays);
+		return 1;
+	}
+
+	printf("seed");
+	for (i = 0; i <= MAX_CURVE_SCORE; i++)
+		printf(",%" PRIu32, i);
+	printf("\n");
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (i = 0; i < Seeds; i++)
+		RateSeed(&Batch, &Bot, First + i, Threads, Scores, &Ratings[i]);
+	clock_gettime(CLOCK_MONOTONIC, &End);
+
+	// Difficulty is the share of the other seeds that are easier. Seeds with
+	// the same mean score get the same difficulty.
+	qsort(Ratings, Seeds, sizeof(struct SeedRating), CompareMeanScores);
+	uint32_t Easier = 0;
+	for (i = 0; i < Seeds; i++)
+	{
+		if (i > 0 && Ratings[i].MeanScore != Ratings[i - 1].MeanScore)
+			Easier = i;
+		Ratings[i].Difficulty = (uint16_t) (Seeds > 1 ? Easier * 100 / (Seeds - 1) : 0);
+	}
+
+	fprintf(stderr, "%" PRIu32 " seeds x %" PRIu32 " plays in %.3f s\n", Seeds, Plays,
+		(End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec) / 1e9);
+	bool Saved = SaveSeedCatalog(Ratings, Seeds, Path);
+
+	FinalizeGameBatch(&Batch);
+	free(Bot.Noise);
+	free(Bot.Aim);
+	free(Scores);
+	free(Ratings);
+	return Saved ? 0 : 1;
+}
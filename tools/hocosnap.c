@@ -0,0 +1,135 @@
+/*
+ * Hocoslamfy, game snapshot benchmark
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// Measures how long SaveGameState and LoadGameState take, and checks that a
+// game played again from a snapshot plays out the same way.
+// Usage: hocosnap [iterations [seed]]
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <time.h>
+
+#include "sim.h"
+#include "controller.h"
+#include "args.h"
+
+// The number of milliseconds played with the autopilot after each snapshot
+// before comparing.
+#define CHECK_TIME 2000
+
+static double Seconds(const struct timespec* Start, const struct timespec* End)
+{
+	return (End->tv_sec - Start->tv_sec) + (End->tv_nsec - Start->tv_nsec) / 1e9;
+}
+
+static void Play(struct GameState* State, uint32_t Milliseconds)
+{
+	struct ControllerView View;
+	uint32_t i;
+	for (i = 0; i < Milliseconds && State->PlayerStatus != DEAD; i++)
+	{
+		GetControllerView(State, &View);
+		AdvanceGameState(State, AutopilotController(&View, NULL), 1);
+	}
+}
+
+// Saves a snapshot with its padding cleared, so that snapshots can be
+// compared with memcmp.
+static void Save(const struct GameState* State, struct GameSnapshot* Snapshot)
+{
+	memset(Snapshot, 0, sizeof(*Snapshot));
+	SaveGameState(State, Snapshot);
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t Iterations = 10000000;
+	uint64_t Seed       = 1;
+	struct GameState State;
+	struct GameSnapshot Snapshot, First, Second;
+	struct timespec Start, End;
+	uint32_t i, Checks = 0, Mismatches = 0;
+
+	if (argc > 3
+	 || (argc > 1 && !ParseUint32(argv[1], 1, &Iterations))
+	 || (argc > 2 && !ParseUint64(argv[2], &Seed)))
+	{
+		fprintf(stderr, "Usage: %s [iterations [seed]]\n", argv[0]);
+		return 2;
+	}
+	if (!InitializeGameState(&State, Seed))
+	{
+		printf("Failed to allocate the rectangles of the game\n");
+		return 1;
+	}
+
+	// Check, every second of a game, that playing on from a snapshot of it
+	// gives the same game as playing on from where the snapshot was taken.
+	while (State.PlayerStatus != DEAD)
+	{
+		Save(&State, &Snapshot);
+		Play(&State, CHECK_TIME);
+		Save(&State, &First);
+		LoadGameState(&State, &Snapshot);
+		Play(&State, CHECK_TIME);
+		Save(&State, &Second);
+		Checks++;
+		if (memcmp(&First, &Second, sizeof(First)) != 0)
+			Mismatches++;
+		LoadGameState(&State, &Snapshot);
+		Play(&State, 1000);
+	}
+
+	// Time both in the middle of a game, with columns on the field.
+	ResetGameState(&State, Seed);
+	Play(&State, 10000);
+	printf("Snapshot: %u bytes, %" PRIu32 " rectangles on the field\n",
+		(unsigned int) sizeof(struct GameSnapshot), State.RectangleCount);
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (i = 0; i < Iterations; i++)
+	{
+		SaveGameState(&State, &Snapshot);
+		__asm__ __volatile__ ("" : : "m" (Snapshot) : "memory");
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	double SaveTime = Seconds(&Start, &End);
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (i = 0; i < Iterations; i++)
+	{
+		LoadGameState(&State, &Snapshot);
+		__asm__ __volatile__ ("" : : "m" (State) : "memory");
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	double LoadTime = Seconds(&Start, &End);
+
+	printf("SaveGameState: %.1f ns, LoadGameState: %.1f ns (%" PRIu32 " iterations)\n",
+		SaveTime / Iterations * 1e9, LoadTime / Iterations * 1e9, Iterations);
+	printf("%" PRIu32 " snapshots played on for %u ms: %" PRIu32 " mismatched\n",
+		Checks, CHECK_TIME, Mismatches);
+
+	FinalizeGameState(&State);
+	return Mismatches != 0 ? 1 : 0;
+}
@@ -0,0 +1,437 @@
+/*
+ * Hocoslamfy, best play search tool
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// Searches for the best score that can be reached in the game started with a
+// given seed, boosting or not at the start of every tick of a given number of
+// milliseconds, and prints the boosts that reach it.
+// Usage: hocosolve [seed [seconds [tick [threads [replay-file]]]]]
+//
+// Columns go by at the same times whatever the player does, and the score is
+// the number of columns that went by, so the best score is that of the
+// longest-lived player. The search goes depth-first from the start of the
+// game, over states of the player (its height and speed at the start of a
+// tick), and doesn't go on from a state whose height and speed are close
+// enough to those of one that was already reached at the same tick. The
+// result is a score that can surely be reached, and it's the best one unless
+// that closeness hid a better way.
+// Each thread has a deque of states to go on from. It takes the latest one
+// from its own, and the oldest one from another's when its own is empty.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "sim.h"
+#include "collision.h"
+#include "replay.h"
+#include "args.h"
+
+// States are the same if their heights and speeds are the same after being
+// shifted right by these. That's 7.6 mm and 0.12 m/s.
+#define SOLVE_Y_SHIFT     17
+#define SOLVE_SPEED_SHIFT 11
+
+// The number of states that can be reached before the search gives up.
+#define SOLVE_STATES      (1 << 22)
+
+// The number of states each thread's deque can hold. The search is
+// depth-first, so it holds about one per tick.
+#define SOLVE_DEQUE_SIZE  (1 << 18)
+
+#define SOLVE_NONE        UINT32_MAX
+
+struct SolveNode
+{
+	fixed    PlayerY;
+	fixed    PlayerSpeed;
+	// The state this one was reached from, and whether the player boosted
+	// to reach it.
+	uint32_t Parent;
+	uint32_t Tick : 31;
+	uint32_t Boost : 1;
+};
+
+// A Chase-Lev work-stealing deque of node indices. Only its thread pushes and
+// pops at Bottom; other threads steal at Top.
+struct SolveDeque
+{
+	uint32_t         Items[SOLVE_DEQUE_SIZE];
+	volatile int32_t Top;
+	volatile int32_t Bottom;
+};
+
+static uint32_t             TickTime;
+static uint32_t             MaxTicks;
+// The columns at the start of each tick, in a game whose player avoids them.
+static struct GameSnapshot* Columns;
+
+static struct SolveNode*    Nodes;
+static volatile uint32_t    NodeCount;
+// Keys of the states reached so far, in an open-addressing hash table with
+// twice as many entries as SOLVE_STATES; 0 is an empty entry.
+static volatile uint64_t*   Keys;
+#define SOLVE_KEY_MASK      (2 * SOLVE_STATES - 1)
+
+static struct SolveDeque*   Deques;
+static uint32_t             Threads;
+// The number of nodes pushed onto deques and not yet expanded.
+static volatile uint32_t    Pending;
+// The tick of the deepest node in the high 32 bits, and its index in the low.
+static volatile uint64_t    Deepest;
+static volatile bool        Done;
+static volatile bool        Full;
+// Whether a deque filled up, which also stops the search.
+static volatile bool        DequeFull;
+
+static double Seconds(const struct timespec* Start, const struct timespec* End)
+{
+	return (End->tv_sec - Start->tv_sec) + (End->tv_nsec - Start->tv_nsec) / 1e9;
+}
+
+// Returns false if the deque is full. Thieves only ever make room, so a stale
+// Top can only make it look fuller than it is.
+static bool Push(struct SolveDeque* Deque, uint32_t Node)
+{
+	int32_t Bottom = Deque->Bottom;
+	if (Bottom - Deque->Top >= SOLVE_DEQUE_SIZE)
+		return false;
+	Deque->Items[Bottom & (SOLVE_DEQUE_SIZE - 1)] = Node;
+	__sync_synchronize();
+	Deque->Bottom = Bottom + 1;
+	return true;
+}
+
+static uint32_t Pop(struct SolveDeque* Deque)
+{
+	int32_t Bottom = Deque->Bottom - 1, Top;
+	uint32_t Node = SOLVE_NONE;
+	Deque->Bottom = Bottom;
+	__sync_synchronize();
+	Top = Deque->Top;
+	if (Top <= Bottom)
+	{
+		Node = Deque->Items[Bottom & (SOLVE_DEQUE_SIZE - 1)];
+		if (Top == Bottom)
+		{
+			// The last node; a thief may be taking it too.
+			if (!__sync_bool_compare_and_swap(&Deque->Top, Top, Top + 1))
+				Node = SOLVE_NONE;
+			Deque->Bottom = Bottom + 1;
+		}
+	}
+	else
+		Deque->Bottom = Bottom + 1;
+	return Node;
+}
+
+static uint32_t Steal(struct SolveDeque* Deque)
+{
+	int32_t Top = Deque->Top;
+	__sync_synchronize();
+	int32_t Bottom = Deque->Bottom;
+	if (Top < Bottom)
+	{
+		uint32_t Node = Deque->Items[Top & (SOLVE_DEQUE_SIZE - 1)];
+		if (__sync_bool_compare_and_swap(&Deque->Top, Top, Top + 1))
+			return Node;
+	}
+	return SOLVE_NONE;
+}
+
+// Marks a state as reached. Returns false if it already was.
+static bool Reach(uint32_t Tick, fixed PlayerY, fixed PlayerSpeed)
+{
+	uint64_t Key = ((uint64_t) Tick << 40)
+	             ^ ((uint64_t) (uint32_t) (PlayerY >> SOLVE_Y_SHIFT) << 20)
+	             ^ (uint64_t) ((uint32_t) (PlayerSpeed >> SOLVE_SPEED_SHIFT) & 0xFFFFF);
+	Key = Key * 2 + 1;
+	uint64_t Hash = Key * UINT64_C(0x9E3779B97F4A7C15);
+	uint32_t Slot = (uint32_t) (Hash >> 32) & SOLVE_KEY_MASK;
+
+	while (true)
+	{
+		uint64_t Existing = Keys[Slot];
+		if (Existing == Key)
+			return false;
+		if (Existing == 0)
+		{
+			if (__sync_bool_compare_and_swap(&Keys[Slot], 0, Key))
+				return true;
+			continue;
+		}
+		Slot = (Slot + 1) & SOLVE_KEY_MASK;
+	}
+}
+
+static void UpdateDeepest(uint32_t Tick, uint32_t Node)
+{
+	uint64_t Old, New = ((uint64_t) Tick << 32) | Node;
+	while ((Old = Deepest) >> 32 < Tick)
+		if (__sync_bool_compare_and_swap(&Deepest, Old, New))
+			break;
+	if (Tick == MaxTicks)
+		Done = true;
+}
+
+static void Expand(struct GameState* State, struct SolveDeque* Deque, uint32_t Index)
+{
+	struct SolveNode Node = Nodes[Index];
+	int Boost;
+
+	for (Boost = 1; Boost >= 0 && !Done; Boost--)
+	{
+		LoadGameState(State, &Columns[Node.Tick]);
+		State->PlayerY = Node.PlayerY;
+		State->PlayerSpeed = Node.PlayerSpeed;
+		AdvanceGameState(State, Boost, TickTime);
+		if (State->PlayerStatus != ALIVE
+		 || !Reach(Node.Tick + 1, State->PlayerY, State->PlayerSpeed))
+			continue;
+
+		uint32_t Child = __sync_fetch_and_add(&NodeCount, 1);
+		if (Child >= SOLVE_STATES)
+		{
+			Full = Done = true;
+			return;
+		}
+		Nodes[Child] = (struct SolveNode) {
+			.PlayerY = State->PlayerY,
+			.PlayerSpeed = State->PlayerSpeed,
+			.Parent = Index,
+			.Tick = Node.Tick + 1,
+			.Boost = Boost
+		};
+		UpdateDeepest(Node.Tick + 1, Child);
+		if (Node.Tick + 1 < MaxTicks)
+		{
+			// Counted before it can be stolen, so that Pending can't reach 0
+			// while the child is still to be expanded.
+			__sync_fetch_and_add(&Pending, 1);
+			if (!Push(Deque, Child))
+			{
+				__sync_fetch_and_sub(&Pending, 1);
+				DequeFull = Done = true;
+				return;
+			}
+		}
+	}
+}
+
+static void* SolveThread(void* Arg)
+{
+	uint32_t Self = (uint32_t) (uintptr_t) Arg, i, Node;
+	struct SolveDeque* Deque = &Deques[Self];
+	struct GameState State;
+
+	if (!InitializeGameState(&State, 0))
+	{
+		Full = Done = true;
+		return NULL;
+	}
+	while (!Done)
+	{
+		Node = Pop(Deque);
+		for (i = 1; Node == SOLVE_NONE && i < Threads; i++)
+			Node = Steal(&Deques[(Self + i) % Threads]);
+		if (Node == SOLVE_NONE)
+		{
+			if (Pending == 0)
+				break;
+			sched_yield();
+			continue;
+		}
+		Expand(&State, Deque, Node);
+		__sync_fetch_and_sub(&Pending, 1);
+	}
+	FinalizeGameState(&State);
+	return NULL;
+}
+
+// Returns a height at which the player won't collide with anything during the
+// next tick: in the gap of the column it's in or about to be in, or in the
+// middle of the field.
+static fixed SafePlayerY(const struct GameState* State)
+{
+	fixed Ahead = FIXED_PLAYER_X + COLLISION_A_HALF_WIDTH - (fixed) TickTime * State->Parameters.FieldScroll;
+	uint32_t i;
+	for (i = State->RectangleCursor; i + 1 < State->RectangleCount; i += 2)
+	{
+		uint32_t Top = RectangleSlot(State, i);
+		if (State->Rectangles.Left[Top] < Ahead)
+			return State->Rectangles.Bottom[Top] - State->Parameters.GapHeight / 2;
+	}
+	return FIXED_FIELD_HEIGHT / 2;
+}
+
+// Plays the columns of a game, keeping its player out of their way, to get
+// where they are at the start of every tick.
+static bool PrepareColumns(uint64_t Seed)
+{
+	struct GameState State;
+	uint32_t i;
+
+	if ((Columns = malloc((MaxTicks + 1) * sizeof(struct GameSnapshot))) == NULL
+	 || !InitializeGameState(&State, Seed))
+		return false;
+	for (i = 0; i <= MaxTicks; i++)
+	{
+		SaveGameState(&State, &Columns[i]);
+		State.PlayerY = SafePlayerY(&State);
+		State.PlayerSpeed = 0;
+		AdvanceGameState(&State, false, TickTime);
+		if (State.PlayerStatus != ALIVE)
+		{
+			printf("The columns can't be played without colliding at %" PRIu32 " ms\n", State.Time);
+			FinalizeGameState(&State);
+			return false;
+		}
+	}
+	FinalizeGameState(&State);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	uint64_t    Seed        = 1;
+	uint32_t    MaxSeconds  = 60;
+	const char* ReplayPath  = argc > 5 ? argv[5] : NULL;
+	struct timespec Start, End;
+	uint32_t i, Started = 0;
+
+	TickTime = 20;
+	Threads  = 0;
+	if (argc > 6
+	 || (argc > 1 && !ParseUint64(argv[1], &Seed))
+	 || (argc > 2 && !ParseUint32(argv[2], 1, &MaxSeconds))
+	 || (argc > 3 && !ParseUint32(argv[3], 1, &TickTime))
+	 || (argc > 4 && !ParseUint32(argv[4], 0, &Threads)))
+	{
+		fprintf(stderr, "Usage: %s [seed [seconds [tick [threads [replay-file]]]]]\n", argv[0]);
+		return 2;
+	}
+	if (Threads == 0)
+	{
+		long Processors = sysconf(_SC_NPROCESSORS_ONLN);
+		Threads = Processors > 0 ? (uint32_t) Processors : 1;
+	}
+	MaxTicks = MaxSeconds * 1000 / TickTime;
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	Nodes = malloc(SOLVE_STATES * sizeof(struct SolveNode));
+	Keys = calloc(2 * SOLVE_STATES, sizeof(uint64_t));
+	Deques = calloc(Threads, sizeof(struct SolveDeque));
+	if (Nodes == NULL || Keys == NULL || Deques == NULL || !PrepareColumns(Seed))
+	{
+		printf("Failed to prepare the search\n");
+		return 1;
+	}
+
+	Nodes[0] = (struct SolveNode) {
+		.PlayerY = Columns[0].PlayerY,
+		.PlayerSpeed = Columns[0].PlayerSpeed,
+		.Parent = SOLVE_NONE,
+		.Tick = 0,
+		.Boost = 0
+	};
+	Reach(0, Nodes[0].PlayerY, Nodes[0].PlayerSpeed);
+	NodeCount = 1;
+	Deepest = 0;
+	Pending = 1;
+	Push(&Deques[0], 0);
+
+	pthread_t* Handles = NULL;
+	if (Threads > 1 && (Handles = malloc((Threads - 1) * sizeof(pthread_t))) != NULL)
+		for (i = 1; i < Threads; i++)
+			if (pthread_create(&Handles[Started], NULL, SolveThread, (void*) (uintptr_t) i) == 0)
+				Started++;
+	// Threads that could not be created have empty deques, which are just
+	// never stolen from.
+	SolveThread((void*) (uintptr_t) 0);
+	for (i = 0; i < Started; i++)
+		pthread_join(Handles[i], NULL);
+	free(Handles);
+	clock_gettime(CLOCK_MONOTONIC, &End);
+
+	// Follow the deepest node back to the start to get the boosts, then play
+	// them to check the result.
+	uint32_t BestTick = (uint32_t) (Deepest >> 32), Node = (uint32_t) Deepest;
+	struct Replay Trace;
+	uint32_t* Path = malloc((BestTick + 1) * sizeof(uint32_t));
+	uint32_t PathLength = 0, NextBoost = 0;
+	if (Path == NULL)
+	{
+		printf("Failed to allocate the boosts\n");
+		return 1;
+	}
+	for (i = Node; Nodes[i].Parent != SOLVE_NONE; i = Nodes[i].Parent)
+		Path[PathLength++] = i;
+	InitializeReplay(&Trace, Seed);
+	while (PathLength > 0)
+	{
+		const struct SolveNode* Step = &Nodes[Path[--PathLength]];
+		if (Step->Boost && !RecordBoost(&Trace, (Step->Tick - 1) * TickTime))
+		{
+			printf("Failed to allocate the boosts\n");
+			return 1;
+		}
+	}
+	free(Path);
+
+	struct GameState State;
+	InitializeGameState(&State, Seed);
+	AdvanceReplay(&State, &Trace, &NextBoost, BestTick * TickTime);
+	bool Reproduced = State.PlayerStatus == ALIVE && State.Score == Columns[BestTick].Score;
+	// Then let the player fall without boosting until the game is over, so
+	// that the replay ends like those the game saves, and verifies like them.
+	while (State.PlayerStatus != DEAD)
+		AdvanceReplay(&State, &Trace, &NextBoost, TickTime);
+	Trace.Score = State.Score;
+	Trace.Duration = State.Time;
+
+	printf("%" PRIu32 " states reached on %" PRIu32 " threads in %.3f s%s\n",
+		NodeCount < SOLVE_STATES ? NodeCount : SOLVE_STATES, Started + 1, Seconds(&Start, &End),
+		Full ? " (out of room; the score is only a lower bound)" : "");
+	if (DequeFull)
+		printf("Error: a thread had more than %u states left to go on from; the search stopped early, and the score is only a lower bound\n", SOLVE_DEQUE_SIZE);
+	printf("Best: score %" PRIu32 ", alive after %" PRIu32 " ms%s%s\n",
+		Columns[BestTick].Score, BestTick * TickTime,
+		BestTick == MaxTicks ? " (the end of the search)" : "",
+		Reproduced ? "" : " (NOT REPRODUCED)");
+	printf("Boosts at (ms):");
+	for (i = 0; i < Trace.BoostCount; i++)
+		printf(" %" PRIu32, Trace.BoostTimes[i]);
+	printf("\n");
+	if (ReplayPath != NULL)
+	{
+		if (SaveReplay(&Trace, ReplayPath))
+			printf("Saved the replay to %s: score %" PRIu32 ", game over after %" PRIu32 " ms\n", ReplayPath, Trace.Score, Trace.Duration);
+	}
+
+	FinalizeReplay(&Trace);
+	FinalizeGameState(&State);
+	return DequeFull ? 1 : 0;
+}
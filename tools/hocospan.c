@@ -0,0 +1,340 @@
+/*
+ * Hocoslamfy, span image test and benchmark
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// Checks that BlitSpanImage, which blits span sprites, draws the same pixels
+// as a blit of every pixel with SDL's clipping, for random source,
+// destination and clipping rectangles. Then measures how long it takes to
+// draw the columns and the bee of a frame, with and without a clipping
+// rectangle, against SDL 1.2's C per-pixel alpha blitter.
+// The images aren't loaded from data/, which needs SDL_image. They are made
+// with the same sizes and layout: opaque shapes with soft edges in 64-pixel
+// column frames and 32-pixel bee frames.
+// Usage: hocospan [blits [seed]]
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <time.h>
+
+#include "blend.h"
+#include "span.h"
+#include "args.h"
+
+#define SCREEN_WIDTH  320
+#define SCREEN_HEIGHT 240
+
+// The number of frames drawn in the benchmark.
+#define FRAMES 20000
+
+struct TestImage
+{
+	int       Width;
+	int       Height;
+	// The pixels as SDL would have them: not premultiplied.
+	uint32_t* Pixels;
+	struct SpanImage Spans;
+};
+
+static uint64_t RandomState;
+
+static uint32_t Random(void)
+{
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 7;
+	RandomState ^= RandomState << 17;
+	return (uint32_t) (RandomState >> 32);
+}
+
+// Returns a random integer between Low and High, inclusive.
+static int RandomBetween(int Low, int High)
+{
+	return Low + (int) (Random() % (uint32_t) (High - Low + 1));
+}
+
+static double Seconds(const struct timespec* Start, const struct timespec* End)
+{
+	return (End->tv_sec - Start->tv_sec) + (End->tv_nsec - Start->tv_nsec) / 1e9;
+}
+
+// Returns the alpha of a pixel Inside pixels inside the edge of a shape: 0
+// outside, partly transparent on the edge, and Body inside.
+static uint32_t EdgeAlpha(double Inside, uint32_t Body)
+{
+	if (Inside < 0)
+		return 0;
+	if (Inside < 1)
+		return 1 + (uint32_t) (Inside * 253);
+	return Body;
+}
+
+// Makes Bamboo.png: 3 frames of columns 64 pixels apart, with wavy sides.
+static void MakeColumns(struct TestImage* Image)
+{
+	int x, y;
+	for (y = 0; y < Image->Height; y++)
+		for (x = 0; x < Image->Width; x++)
+		{
+			int Frame = x / 64;
+			double Left = 20 + 2 * sin(y * 0.05 + Frame), Right = 44 + 2 * cos(y * 0.07 + Frame),
+			       Inside = x % 64 - Left < Right - x % 64 ? x % 64 - Left : Right - x % 64;
+			Image->Pixels[y * Image->Width + x] = EdgeAlpha(Inside, 0xFF) << 24 | (Random() & 0xFFFFFF);
+		}
+}
+
+// Makes Bee.png or Crash.png: frames of Size pixels with a body in the
+// middle and translucent wings around it.
+static void MakeDiscs(struct TestImage* Image, int Size)
+{
+	int x, y;
+	for (y = 0; y < Image->Height; y++)
+		for (x = 0; x < Image->Width; x++)
+		{
+			double DX = x % Size - Size / 2 + 0.5, DY = y - Image->Height / 2 + 0.5,
+			       Distance = sqrt(DX * DX + DY * DY);
+			Image->Pixels[y * Image->Width + x] = EdgeAlpha(Size * 3 / 8 - Distance, Distance > Size / 4 ? 0xA0 : 0xFF) << 24
+				| (Random() & 0xFFFFFF);
+		}
+}
+
+static void MakeImage(struct TestImage* Image, int Width, int Height)
+{
+	Image->Width = Width;
+	Image->Height = Height;
+	if ((Image->Pixels = malloc(Width * Height * sizeof(uint32_t))) == NULL)
+	{
+		printf("Out of memory\n");
+		exit(2);
+	}
+}
+
+static void MakeSpans(struct TestImage* Image, const char* Name)
+{
+	if (!MakeSpanImage(&Image->Spans, Image->Pixels, Image->Width, Image->Height, Image->Width * sizeof(uint32_t)))
+	{
+		printf("Out of memory\n");
+		exit(2);
+	}
+	printf("%s: %dx%d, %" PRIu32 " spans\n", Name, Image->Width, Image->Height, Image->Spans.RowStart[Image->Height]);
+}
+
+// Blits every pixel of the image that is in both the Source rectangle and
+// the image, and whose place on the screen is in Clip, with the portable
+// blending kernel.
+static void ReferenceBlit(const struct TestImage* Image, const struct SpanRect* Source, uint32_t* Dest, int DestX, int DestY, const struct SpanRect* Clip, TBlendKernel Blend)
+{
+	int x, y;
+	for (y = Source->Y; y < Source->Y + Source->Height; y++)
+		for (x = Source->X; x < Source->X + Source->Width; x++)
+		{
+			int ScreenX = DestX + x - Source->X, ScreenY = DestY + y - Source->Y;
+			if (x < 0 || x >= Image->Width || y < 0 || y >= Image->Height
+			 || ScreenX < Clip->X || ScreenX >= Clip->X + Clip->Width
+			 || ScreenY < Clip->Y || ScreenY >= Clip->Y + Clip->Height)
+				continue;
+			const uint32_t* Pixel = &Image->Spans.Pixels[y * Image->Width + x];
+			if ((*Pixel >> 24) != 0)
+				Blend(&Dest[ScreenY * SCREEN_WIDTH + ScreenX], Pixel, 1);
+		}
+}
+
+// What SDL 1.2's C blitter does for 32-bit pixels with alpha, without
+// premultiplication.
+static void BlendLikeSDL(uint32_t* Dest, const uint32_t* Source, uint32_t Count)
+{
+	uint32_t i;
+	for (i = 0; i < Count; i++)
+	{
+		uint32_t S = Source[i], D = Dest[i], Alpha = S >> 24;
+		if (Alpha == 0xFF)
+			Dest[i] = (S & 0xFFFFFF) | (D & 0xFF000000);
+		else
+		{
+			uint32_t S1 = S & 0xFF00FF, D1 = D & 0xFF00FF;
+			D1 = (D1 + ((S1 - D1) * Alpha >> 8)) & 0xFF00FF;
+			S &= 0xFF00;
+			uint32_t D2 = D & 0xFF00;
+			D2 = (D2 + ((S - D2) * Alpha >> 8)) & 0xFF00;
+			Dest[i] = D1 | D2 | (D & 0xFF000000);
+		}
+	}
+}
+
+// SDL_BlitSurface with SDL 1.2's C per-pixel alpha blitter.
+static void BlitLikeSDL(const struct TestImage* Image, const struct SpanRect* Source, uint32_t* Dest, int DestX, int DestY, const struct SpanRect* Clip)
+{
+	int SourceX = Source->X, SourceY = Source->Y,
+	    Width = Source->Width, Height = Source->Height, y;
+
+	if (SourceX < 0)
+	{
+		Width += SourceX;  DestX -= SourceX;  SourceX = 0;
+	}
+	if (SourceX + Width > Image->Width)
+		Width = Image->Width - SourceX;
+	if (SourceY < 0)
+	{
+		Height += SourceY;  DestY -= SourceY;  SourceY = 0;
+	}
+	if (SourceY + Height > Image->Height)
+		Height = Image->Height - SourceY;
+	if (DestX < Clip->X)
+	{
+		Width -= Clip->X - DestX;  SourceX += Clip->X - DestX;  DestX = Clip->X;
+	}
+	if (DestX + Width > Clip->X + Clip->Width)
+		Width = Clip->X + Clip->Width - DestX;
+	if (DestY < Clip->Y)
+	{
+		Height -= Clip->Y - DestY;  SourceY += Clip->Y - DestY;  DestY = Clip->Y;
+	}
+	if (DestY + Height > Clip->Y + Clip->Height)
+		Height = Clip->Y + Clip->Height - DestY;
+	if (Width <= 0 || Height <= 0)
+		return;
+
+	for (y = 0; y < Height; y++)
+		BlendLikeSDL(&Dest[(DestY + y) * SCREEN_WIDTH + DestX], &Image->Pixels[(SourceY + y) * Image->Width + SourceX], Width);
+}
+
+// Draws the columns and the bee of a frame of a game: 4 pairs of columns
+// 80 pixels apart, with a gap between each pair, and the bee.
+static void DrawFrame(const struct TestImage* Columns, const struct TestImage* Bee, uint32_t Frame, uint32_t* Dest, const struct SpanRect* Clip, bool Spans)
+{
+	uint32_t i;
+	for (i = 0; i < 8; i++)
+	{
+		int Height = i & 1 ? 130 - 10 * (int) (i / 2) : 60 + 10 * (int) (i / 2),
+		    X = 80 * (int) (i / 2) - 20 + (int) (Frame % 80);
+		struct SpanRect Source = { 64 * (int) ((Frame / 8 + i) % 3), i & 1 ? 0 : 480 - Height, 65, Height };
+		int Y = i & 1 ? SCREEN_HEIGHT - Height : 0;
+		if (Spans)
+			BlitSpanImage(&Columns->Spans, &Source, Dest, SCREEN_WIDTH * sizeof(uint32_t), X, Y, Clip);
+		else
+			BlitLikeSDL(Columns, &Source, Dest, X, Y, Clip);
+	}
+	struct SpanRect Source = { 32 * (int) (Frame % 10), 0, 32, 32 };
+	if (Spans)
+		BlitSpanImage(&Bee->Spans, &Source, Dest, SCREEN_WIDTH * sizeof(uint32_t), 100, 104, Clip);
+	else
+		BlitLikeSDL(Bee, &Source, Dest, 100, 104, Clip);
+}
+
+static double TimeFrames(const struct TestImage* Columns, const struct TestImage* Bee, uint32_t* Dest, const struct SpanRect* Clip, bool Spans)
+{
+	struct timespec Start, End;
+	uint32_t i;
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	for (i = 0; i < FRAMES; i++)
+	{
+		DrawFrame(Columns, Bee, i, Dest, Clip, Spans);
+		__asm__ __volatile__ ("" : : "r" (Dest) : "memory");
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	return Seconds(&Start, &End) / FRAMES;
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t Blits = 20000;
+	RandomState = 1;
+	if (argc > 3
+	 || (argc > 1 && !ParseUint32(argv[1], 1, &Blits))
+	 || (argc > 2 && !ParseUint64(argv[2], &RandomState)))
+	{
+		fprintf(stderr, "Usage: %s [blits [seed]]\n", argv[0]);
+		return 2;
+	}
+	if (RandomState == 0)
+		RandomState = 1;
+
+	const struct BlendKernel* Kernels;
+	struct TestImage Images[3];
+	static uint32_t Screen[SCREEN_WIDTH * SCREEN_HEIGHT], Expected[SCREEN_WIDTH * SCREEN_HEIGHT];
+	uint32_t Mismatches = 0, i, j;
+
+	GetBlendKernels(&Kernels);
+	MakeImage(&Images[0], 192, 480);
+	MakeColumns(&Images[0]);
+	MakeSpans(&Images[0], "Columns");
+	MakeImage(&Images[1], 320, 32);
+	MakeDiscs(&Images[1], 32);
+	MakeSpans(&Images[1], "Bee");
+	MakeImage(&Images[2], 48, 48);
+	MakeDiscs(&Images[2], 48);
+	MakeSpans(&Images[2], "Crash");
+
+	for (j = 0; j < SCREEN_WIDTH * SCREEN_HEIGHT; j++)
+		Screen[j] = Random();
+	// Random blits over one another, from rectangles that may stick out of the image, to
+	// places that may stick out of the screen, with random clipping
+	// rectangles half of the time.
+	for (i = 0; i < Blits; i++)
+	{
+		const struct TestImage* Image = &Images[Random() % 3];
+		struct SpanRect Source = {
+			RandomBetween(-10, Image->Width + 10), RandomBetween(-10, Image->Height + 10),
+			RandomBetween(0, Image->Width + 10), RandomBetween(0, Image->Height + 10) },
+		                Clip = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+		int DestX = RandomBetween(-60, SCREEN_WIDTH + 20), DestY = RandomBetween(-60, SCREEN_HEIGHT + 20);
+		if (Random() % 2)
+		{
+			Clip.X = RandomBetween(0, SCREEN_WIDTH - 1);
+			Clip.Y = RandomBetween(0, SCREEN_HEIGHT - 1);
+			Clip.Width = RandomBetween(1, SCREEN_WIDTH - Clip.X);
+			Clip.Height = RandomBetween(1, SCREEN_HEIGHT - Clip.Y);
+		}
+		memcpy(Expected, Screen, sizeof(Screen));
+		ReferenceBlit(Image, &Source, Expected, DestX, DestY, &Clip, Kernels[0].Blend);
+		BlitSpanImage(&Image->Spans, &Source, Screen, SCREEN_WIDTH * sizeof(uint32_t), DestX, DestY, &Clip);
+		if (memcmp(Screen, Expected, sizeof(Screen)) != 0)
+		{
+			if (Mismatches++ < 10)
+				printf("Mismatch blitting %dx%d from (%d, %d) to (%d, %d), clipped to %dx%d at (%d, %d)\n",
+					Source.Width, Source.Height, Source.X, Source.Y, DestX, DestY,
+					Clip.Width, Clip.Height, Clip.X, Clip.Y);
+			memcpy(Screen, Expected, sizeof(Screen));
+		}
+	}
+	printf("%" PRIu32 " random blits: %" PRIu32 " mismatches\n", Blits, Mismatches);
+
+	// Whole frames, then frames clipped to a quarter of the screen, as the
+	// dirty-rectangle renderer may do.
+	struct SpanRect Full = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT },
+	                Quarter = { 80, 60, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 };
+	printf("Columns and bee: SDL 1.2 (C) %.2f us per frame, spans %.2f us per frame\n",
+		TimeFrames(&Images[0], &Images[1], Screen, &Full, false) * 1e6,
+		TimeFrames(&Images[0], &Images[1], Screen, &Full, true) * 1e6);
+	printf("Clipped to %dx%d: SDL 1.2 (C) %.2f us per frame, spans %.2f us per frame\n",
+		Quarter.Width, Quarter.Height,
+		TimeFrames(&Images[0], &Images[1], Screen, &Quarter, false) * 1e6,
+		TimeFrames(&Images[0], &Images[1], Screen, &Quarter, true) * 1e6);
+
+	for (i = 0; i < 3; i++)
+	{
+		FreeSpanImage(&Images[i].Spans);
+		free(Images[i].Pixels);
+	}
+	return Mismatches != 0 ? 1 : 0;
+}
@@ -0,0 +1,271 @@
+/*
+ * Hocoslamfy, replay verification tool
+ * Copyright (C) 2014 Nebuleon Fumika <nebuleon@gcw-zero.com>
+ * 
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+// Plays every replay file (*.hcr) in a directory again and reports those
+// whose recorded score or duration doesn't match what the game gives.
+// Usage: hocoverify directory [threads]
+// Exits with status 1 if any replay doesn't match or can't be read.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+#include <time.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "sim.h"
+#include "replay.h"
+#include "args.h"
+
+enum VerifyResult
+{
+	VERIFY_MATCH,
+	VERIFY_MISMATCH,
+	VERIFY_UNREADABLE,
+	VERIFY_NO_MEMORY
+};
+
+struct Verification
+{
+	char*             Path;
+	enum VerifyResult Result;
+	// What the replay claims, and what playing it again gave.
+	uint32_t          RecordedScore;
+	uint32_t          RecordedDuration;
+	uint32_t          Score;
+	uint32_t          Duration;
+	// The number of seconds it took to play the replay again.
+	double            Elapsed;
+};
+
+struct VerifyRun
+{
+	struct Verification* Verifications;
+	uint32_t             Count;
+	uint32_t             Next;
+};
+
+static double Seconds(const struct timespec* Start, const struct timespec* End)
+{
+	return (End->tv_sec - Start->tv_sec) + (End->tv_nsec - Start->tv_nsec) / 1e9;
+}
+
+// Plays a replay from start to finish and checks it with ReplayMatches.
+// The time needed is bounded by the file, not by what it claims: without
+// boosts, the player soon falls out of the field, and AdvanceReplay stops
+// there.
+static void Verify(struct GameState* State, struct Verification* Verification)
+{
+	struct Replay Replay;
+	struct timespec Start, End;
+	uint32_t NextBoost = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	if (!LoadReplay(&Replay, Verification->Path))
+	{
+		Verification->Result = VERIFY_UNREADABLE;
+		return;
+	}
+
+	ResetGameState(State, Replay.Seed);
+	AdvanceReplay(State, &Replay, &NextBoost, Replay.Duration);
+
+	Verification->RecordedScore = Replay.Score;
+	Verification->RecordedDuration = Replay.Duration;
+	Verification->Score = State->Score;
+	Verification->Duration = State->Time;
+	Verification->Result = ReplayMatches(State, &Replay, NextBoost) ? VERIFY_MATCH : VERIFY_MISMATCH;
+	FinalizeReplay(&Replay);
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	Verification->Elapsed = Seconds(&Start, &End);
+}
+
+static void* VerifyThread(void* Arg)
+{
+	struct VerifyRun* Run = Arg;
+	struct GameState State;
+	uint32_t i;
+
+	if (!InitializeGameState(&State, 0))
+	{
+		// Another thread may still verify the replays, but if none can, they
+		// must not be left looking verified.
+		while ((i = __sync_fetch_and_add(&Run->Next, 1)) < Run->Count)
+			Run->Verifications[i].Result = VERIFY_NO_MEMORY;
+		return NULL;
+	}
+	while ((i = __sync_fetch_and_add(&Run->Next, 1)) < Run->Count)
+		Verify(&State, &Run->Verifications[i]);
+	FinalizeGameState(&State);
+	return NULL;
+}
+
+static bool IsReplayName(const char* Name)
+{
+	size_t Length = strlen(Name);
+	return Length > 4 && strcmp(Name + Length - 4, ".hcr") == 0;
+}
+
+static int CompareVerifications(const void* A, const void* B)
+{
+	return strcmp(((const struct Verification*) A)->Path, ((const struct Verification*) B)->Path);
+}
+
+// Gathers the paths of the replay files in a directory, sorted by name.
+// Returns false, after printing why, if the directory can't be read or
+// memory could not be allocated.
+static bool FindReplays(const char* Directory, struct VerifyRun* Run)
+{
+	DIR* Dir = opendir(Directory);
+	struct dirent* Entry;
+	uint32_t Capacity = 0;
+	bool Result = true;
+
+	Run->Verifications = NULL;
+	Run->Count = 0;
+	Run->Next = 0;
+	if (!Dir)
+	{
+		fprintf(stderr, "%s: Unable to open directory.\n", Directory);
+		return false;
+	}
+
+	while (Result && (Entry = readdir(Dir)) != NULL)
+	{
+		if (!IsReplayName(Entry->d_name))
+			continue;
+		if (Run->Count == Capacity)
+		{
+			uint32_t NewCapacity = Capacity != 0 ? Capacity * 2 : 256;
+			struct Verification* NewVerifications = realloc(Run->Verifications, NewCapacity * sizeof(struct Verification));
+			if (NewVerifications == NULL)
+			{
+				Result = false;
+				break;
+			}
+			Run->Verifications = NewVerifications;
+			Capacity = NewCapacity;
+		}
+		struct Verification* Verification = &Run->Verifications[Run->Count];
+		memset(Verification, 0, sizeof(*Verification));
+		Verification->Path = malloc(strlen(Directory) + strlen(Entry->d_name) + 2);
+		if (Verification->Path == NULL)
+		{
+			Result = false;
+			break;
+		}
+		sprintf(Verification->Path, "%s/%s", Directory, Entry->d_name);
+		Run->Count++;
+	}
+	closedir(Dir);
+
+	if (!Result)
+		fprintf(stderr, "%s: Out of memory.\n", Directory);
+	else
+		qsort(Run->Verifications, Run->Count, sizeof(struct Verification), CompareVerifications);
+	return Result;
+}
+
+int main(int argc, char* argv[])
+{
+	struct VerifyRun Run;
+	struct timespec Start, End;
+	uint32_t Threads = 0, Started = 0, i;
+	bool Found;
+
+	if (argc < 2 || argc > 3 || (argc > 2 && !ParseUint32(argv[2], 0, &Threads)))
+	{
+		fprintf(stderr, "Usage: %s directory [threads]\n", argv[0]);
+		return 2;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	Found = FindReplays(argv[1], &Run);
+	if (Found)
+	{
+		if (Threads == 0)
+		{
+			long Processors = sysconf(_SC_NPROCESSORS_ONLN);
+			Threads = Processors > 0 ? (uint32_t) Processors : 1;
+		}
+		if (Threads > Run.Count)
+			Threads = Run.Count > 0 ? Run.Count : 1;
+
+		// This thread verifies replays too, as in RunGameBatch.
+		pthread_t* Handles = NULL;
+		if (Threads > 1 && (Handles = malloc((Threads - 1) * sizeof(pthread_t))) != NULL)
+			for (i = 0; i < Threads - 1; i++)
+				if (pthread_create(&Handles[Started], NULL, VerifyThread, &Run) == 0)
+					Started++;
+		VerifyThread(&Run);
+		for (i = 0; i < Started; i++)
+			pthread_join(Handles[i], NULL);
+		free(Handles);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &End);
+	double Elapsed = Seconds(&Start, &End);
+
+	uint32_t Matches = 0, Mismatches = 0, Errors = 0;
+	double TotalSim = 0.0, MaxSim = 0.0;
+	for (i = 0; i < Run.Count; i++)
+	{
+		struct Verification* Verification = &Run.Verifications[i];
+		switch (Verification->Result)
+		{
+			case VERIFY_MATCH:
+				Matches++;
+				break;
+			case VERIFY_MISMATCH:
+				Mismatches++;
+				printf("%s: MISMATCH: recorded score %" PRIu32 " after %" PRIu32 " ms, played score %" PRIu32 " after %" PRIu32 " ms\n",
+					Verification->Path, Verification->RecordedScore, Verification->RecordedDuration,
+					Verification->Score, Verification->Duration);
+				break;
+			case VERIFY_UNREADABLE:
+				// LoadReplay has already said why.
+				Errors++;
+				break;
+			case VERIFY_NO_MEMORY:
+				Errors++;
+				fprintf(stderr, "%s: Out of memory.\n", Verification->Path);
+				break;
+		}
+		TotalSim += Verification->Elapsed;
+		if (Verification->Elapsed > MaxSim)
+			MaxSim = Verification->Elapsed;
+		free(Verification->Path);
+	}
+	free(Run.Verifications);
+
+	if (!Found)
+		return 1;
+
+	printf("%" PRIu32 " replays on %" PRIu32 " threads in %.3f s: %.0f replays/s\n",
+		Run.Count, Started + 1, Elapsed, Elapsed > 0.0 ? Run.Count / Elapsed : 0.0);
+	printf("Per replay: mean %.3f ms, max %.3f ms\n",
+		Run.Count ? TotalSim / Run.Count * 1e3 : 0.0, MaxSim * 1e3);
+	printf("%" PRIu32 " matched, %" PRIu32 " mismatched, %" PRIu32 " unreadable\n",
+		Matches, Mismatches, Errors);
+	return Mismatches != 0 || Errors != 0 ? 1 : 0;
+}